@@ -1,71 +1,71 @@
-#include <inttypes.h>
-
-// Basic font data for TinyBit
-// 1 bit per pixel, 4x6 pixels per character
-
-const uint8_t basic_font[]  = {
-  0xe0, 0xa0, 0xa0, 0x40, 0x40, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x20, 0x80, 0x00, 0x00, 0x00, 
-  0x20, 0xa0, 0x20, 0x80, 0x80, 0x20, 0xa0, 0x40, 0x00, 0x00, 0x00, 0x40, 0x80, 0x00, 0x00, 0x00, 
-  0x60, 0x00, 0x40, 0x00, 0x80, 0x20, 0x40, 0xe0, 0x00, 0xe0, 0x00, 0x40, 0x80, 0x00, 0x00, 0x00, 
-  0x00, 0x00, 0x80, 0x00, 0x80, 0x20, 0xa0, 0x40, 0x40, 0x00, 0x00, 0x40, 0x00, 0x00, 0x00, 0x00, 
-  0x40, 0x00, 0xa0, 0x00, 0x40, 0x40, 0x00, 0x00, 0x80, 0x00, 0x40, 0x80, 0x80, 0x00, 0x00, 0x00, 
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-  0xe0, 0xc0, 0xe0, 0xe0, 0xa0, 0xe0, 0x80, 0xe0, 0xe0, 0xe0, 0x00, 0x00, 0x20, 0x00, 0x80, 0xe0, 
-  0xa0, 0x40, 0x20, 0x20, 0xa0, 0x80, 0x80, 0x20, 0xa0, 0xa0, 0x40, 0x40, 0x40, 0xe0, 0x40, 0x20, 
-  0xa0, 0x40, 0xe0, 0x60, 0xe0, 0xe0, 0xe0, 0x20, 0xe0, 0xe0, 0x00, 0x00, 0x80, 0x00, 0x20, 0x60, 
-  0xa0, 0x40, 0x80, 0x20, 0x20, 0x20, 0xa0, 0x20, 0xa0, 0x20, 0x40, 0x40, 0x40, 0xe0, 0x40, 0x00, 
-  0xe0, 0xe0, 0xe0, 0xe0, 0x20, 0xe0, 0xe0, 0x20, 0xe0, 0x20, 0x00, 0x80, 0x20, 0x00, 0x80, 0x40, 
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-  0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-  0xa0, 0x60, 0xc0, 0x60, 0xc0, 0xe0, 0xe0, 0x60, 0xa0, 0xe0, 0xe0, 0xa0, 0x80, 0xe0, 0xc0, 0x60, 
-  0xa0, 0xa0, 0xc0, 0x80, 0xa0, 0xc0, 0xc0, 0x80, 0xa0, 0x40, 0x40, 0xc0, 0x80, 0xe0, 0xa0, 0xa0, 
-  0x80, 0xe0, 0xa0, 0x80, 0xa0, 0x80, 0x80, 0xa0, 0xe0, 0x40, 0x40, 0xa0, 0x80, 0xa0, 0xa0, 0xa0, 
-  0x60, 0xa0, 0xe0, 0x60, 0xc0, 0x60, 0x80, 0xe0, 0xa0, 0xe0, 0xc0, 0xa0, 0x60, 0xa0, 0xa0, 0xc0, 
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xc0, 0x80, 0x60, 0x40, 0x00, 
-  0x60, 0x40, 0xc0, 0x60, 0xe0, 0xa0, 0xa0, 0xa0, 0xa0, 0xa0, 0xe0, 0x80, 0x40, 0x20, 0xa0, 0x00, 
-  0xa0, 0xa0, 0xa0, 0x80, 0x40, 0xa0, 0xa0, 0xa0, 0x40, 0xe0, 0x20, 0x80, 0x40, 0x20, 0x00, 0x00, 
-  0xe0, 0xc0, 0xc0, 0x20, 0x40, 0xa0, 0xe0, 0xe0, 0x40, 0x20, 0x80, 0x80, 0x40, 0x20, 0x00, 0x00, 
-  0x80, 0x60, 0xa0, 0xc0, 0x40, 0x60, 0x40, 0xe0, 0xa0, 0xc0, 0xe0, 0xc0, 0x20, 0x60, 0x00, 0xe0, 
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-  0x40, 0xe0, 0xe0, 0x60, 0xc0, 0xe0, 0xe0, 0x60, 0xa0, 0xe0, 0xe0, 0xa0, 0x80, 0xe0, 0xc0, 0x60, 
-  0x20, 0xa0, 0xa0, 0x80, 0xa0, 0x80, 0x80, 0x80, 0xa0, 0x40, 0x40, 0xa0, 0x80, 0xe0, 0xa0, 0xa0, 
-  0x00, 0xe0, 0xc0, 0x80, 0xa0, 0xc0, 0xc0, 0x80, 0xe0, 0x40, 0x40, 0xc0, 0x80, 0xa0, 0xa0, 0xa0, 
-  0x00, 0xa0, 0xa0, 0x80, 0xa0, 0x80, 0x80, 0xa0, 0xa0, 0x40, 0x40, 0xa0, 0x80, 0xa0, 0xa0, 0xa0, 
-  0x00, 0xa0, 0xe0, 0x60, 0xe0, 0xe0, 0x80, 0xe0, 0xa0, 0xe0, 0xc0, 0xa0, 0xe0, 0xa0, 0xa0, 0xc0, 
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-  0xe0, 0x40, 0xe0, 0x60, 0xe0, 0xa0, 0xa0, 0xa0, 0xa0, 0xa0, 0xe0, 0x60, 0x40, 0xc0, 0x00, 0x00, 
-  0xa0, 0xa0, 0xa0, 0x80, 0x40, 0xa0, 0xa0, 0xa0, 0xa0, 0xa0, 0x20, 0x40, 0x40, 0x40, 0x00, 0x00, 
-  0xe0, 0xa0, 0xc0, 0xe0, 0x40, 0xa0, 0xa0, 0xa0, 0x40, 0xe0, 0x40, 0xc0, 0x40, 0x60, 0x00, 0x00, 
-  0x80, 0xc0, 0xa0, 0x20, 0x40, 0xa0, 0xe0, 0xe0, 0xa0, 0x20, 0x80, 0x40, 0x40, 0x40, 0x00, 0x00, 
-  0x80, 0x60, 0xa0, 0xc0, 0x40, 0x60, 0x40, 0xe0, 0xa0, 0xe0, 0xe0, 0x60, 0x40, 0xc0, 0x00, 0x00, 
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+#include <inttypes.h>
+
+// Basic font data for TinyBit
+// 1 bit per pixel, 4x6 pixels per character
+
+const uint8_t basic_font[]  = {
+  0xe0, 0xa0, 0xa0, 0x40, 0x40, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x20, 0x80, 0x00, 0x00, 0x00, 
+  0x20, 0xa0, 0x20, 0x80, 0x80, 0x20, 0xa0, 0x40, 0x00, 0x00, 0x00, 0x40, 0x80, 0x00, 0x00, 0x00, 
+  0x60, 0x00, 0x40, 0x00, 0x80, 0x20, 0x40, 0xe0, 0x00, 0xe0, 0x00, 0x40, 0x80, 0x00, 0x00, 0x00, 
+  0x00, 0x00, 0x80, 0x00, 0x80, 0x20, 0xa0, 0x40, 0x40, 0x00, 0x00, 0x40, 0x00, 0x00, 0x00, 0x00, 
+  0x40, 0x00, 0xa0, 0x00, 0x40, 0x40, 0x00, 0x00, 0x80, 0x00, 0x40, 0x80, 0x80, 0x00, 0x00, 0x00, 
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+  0xe0, 0xc0, 0xe0, 0xe0, 0xa0, 0xe0, 0x80, 0xe0, 0xe0, 0xe0, 0x00, 0x00, 0x20, 0x00, 0x80, 0xe0, 
+  0xa0, 0x40, 0x20, 0x20, 0xa0, 0x80, 0x80, 0x20, 0xa0, 0xa0, 0x40, 0x40, 0x40, 0xe0, 0x40, 0x20, 
+  0xa0, 0x40, 0xe0, 0x60, 0xe0, 0xe0, 0xe0, 0x20, 0xe0, 0xe0, 0x00, 0x00, 0x80, 0x00, 0x20, 0x60, 
+  0xa0, 0x40, 0x80, 0x20, 0x20, 0x20, 0xa0, 0x20, 0xa0, 0x20, 0x40, 0x40, 0x40, 0xe0, 0x40, 0x00, 
+  0xe0, 0xe0, 0xe0, 0xe0, 0x20, 0xe0, 0xe0, 0x20, 0xe0, 0x20, 0x00, 0x80, 0x20, 0x00, 0x80, 0x40, 
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+  0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+  0xa0, 0x60, 0xc0, 0x60, 0xc0, 0xe0, 0xe0, 0x60, 0xa0, 0xe0, 0xe0, 0xa0, 0x80, 0xe0, 0xc0, 0x60, 
+  0xa0, 0xa0, 0xc0, 0x80, 0xa0, 0xc0, 0xc0, 0x80, 0xa0, 0x40, 0x40, 0xc0, 0x80, 0xe0, 0xa0, 0xa0, 
+  0x80, 0xe0, 0xa0, 0x80, 0xa0, 0x80, 0x80, 0xa0, 0xe0, 0x40, 0x40, 0xa0, 0x80, 0xa0, 0xa0, 0xa0, 
+  0x60, 0xa0, 0xe0, 0x60, 0xc0, 0x60, 0x80, 0xe0, 0xa0, 0xe0, 0xc0, 0xa0, 0x60, 0xa0, 0xa0, 0xc0, 
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xc0, 0x80, 0x60, 0x40, 0x00, 
+  0x60, 0x40, 0xc0, 0x60, 0xe0, 0xa0, 0xa0, 0xa0, 0xa0, 0xa0, 0xe0, 0x80, 0x40, 0x20, 0xa0, 0x00, 
+  0xa0, 0xa0, 0xa0, 0x80, 0x40, 0xa0, 0xa0, 0xa0, 0x40, 0xe0, 0x20, 0x80, 0x40, 0x20, 0x00, 0x00, 
+  0xe0, 0xc0, 0xc0, 0x20, 0x40, 0xa0, 0xe0, 0xe0, 0x40, 0x20, 0x80, 0x80, 0x40, 0x20, 0x00, 0x00, 
+  0x80, 0x60, 0xa0, 0xc0, 0x40, 0x60, 0x40, 0xe0, 0xa0, 0xc0, 0xe0, 0xc0, 0x20, 0x60, 0x00, 0xe0, 
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+  0x40, 0xe0, 0xe0, 0x60, 0xc0, 0xe0, 0xe0, 0x60, 0xa0, 0xe0, 0xe0, 0xa0, 0x80, 0xe0, 0xc0, 0x60, 
+  0x20, 0xa0, 0xa0, 0x80, 0xa0, 0x80, 0x80, 0x80, 0xa0, 0x40, 0x40, 0xa0, 0x80, 0xe0, 0xa0, 0xa0, 
+  0x00, 0xe0, 0xc0, 0x80, 0xa0, 0xc0, 0xc0, 0x80, 0xe0, 0x40, 0x40, 0xc0, 0x80, 0xa0, 0xa0, 0xa0, 
+  0x00, 0xa0, 0xa0, 0x80, 0xa0, 0x80, 0x80, 0xa0, 0xa0, 0x40, 0x40, 0xa0, 0x80, 0xa0, 0xa0, 0xa0, 
+  0x00, 0xa0, 0xe0, 0x60, 0xe0, 0xe0, 0x80, 0xe0, 0xa0, 0xe0, 0xc0, 0xa0, 0xe0, 0xa0, 0xa0, 0xc0, 
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+  0xe0, 0x40, 0xe0, 0x60, 0xe0, 0xa0, 0xa0, 0xa0, 0xa0, 0xa0, 0xe0, 0x60, 0x40, 0xc0, 0x00, 0x00, 
+  0xa0, 0xa0, 0xa0, 0x80, 0x40, 0xa0, 0xa0, 0xa0, 0xa0, 0xa0, 0x20, 0x40, 0x40, 0x40, 0x00, 0x00, 
+  0xe0, 0xa0, 0xc0, 0xe0, 0x40, 0xa0, 0xa0, 0xa0, 0x40, 0xe0, 0x40, 0xc0, 0x40, 0x60, 0x00, 0x00, 
+  0x80, 0xc0, 0xa0, 0x20, 0x40, 0xa0, 0xe0, 0xe0, 0xa0, 0x20, 0x80, 0x40, 0x40, 0x40, 0x00, 0x00, 
+  0x80, 0x60, 0xa0, 0xc0, 0x40, 0x60, 0x40, 0xe0, 0xa0, 0xe0, 0xe0, 0x60, 0x40, 0xc0, 0x00, 0x00, 
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
 };
\ No newline at end of file
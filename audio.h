@@ -1,32 +1,35 @@
-#ifndef AUDIO_H
-#define AUDIO_H
-
-#include <stdbool.h>
-
-typedef enum {
-	SINE,
-	SAW,
-	SQUARE,
-	NOISE,
-	REST
-} WAVEFORM;
-
-// Channel indices
-#define CHANNEL_MUSIC 0
-#define CHANNEL_SFX 1
-#define NUM_CHANNELS 2
-
-// Audio initialization and processing
-void tb_audio_init();
-void process_audio();
-
-// ABC notation loading
-// channel_num: CHANNEL_MUSIC or CHANNEL_SFX, abc_string: ABC notation, waveform: synth type, repeat: loop playback
-int audio_load_abc(int channel_num, const char *abc_string, WAVEFORM waveform, bool repeat);
-
-// Channel control
-void audio_stop_channel(int channel_num);
-void audio_stop_all();
-bool is_channel_active(int channel_num);
-
-#endif
+#ifndef AUDIO_H
+#define AUDIO_H
+
+#include <stdbool.h>
+
+#include "tinybit.h"
+
+typedef enum {
+	SINE,
+	SAW,
+	SQUARE,
+	NOISE,
+	REST
+} WAVEFORM;
+
+// Channel indices
+#define CHANNEL_MUSIC 0
+#define CHANNEL_SFX 1
+#define NUM_CHANNELS 2
+
+// Audio initialization and processing
+void tb_audio_init(tinybit_ctx* ctx);
+void process_audio(tinybit_ctx* ctx);
+void audio_skip_frame(tinybit_ctx* ctx);
+
+// ABC notation loading
+// channel_num: CHANNEL_MUSIC or CHANNEL_SFX, abc_string: ABC notation, waveform: synth type, repeat: loop playback
+int audio_load_abc(tinybit_ctx* ctx, int channel_num, const char *abc_string, WAVEFORM waveform, bool repeat);
+
+// Channel control
+void audio_stop_channel(tinybit_ctx* ctx, int channel_num);
+void audio_stop_all(tinybit_ctx* ctx);
+bool is_channel_active(tinybit_ctx* ctx, int channel_num);
+
+#endif
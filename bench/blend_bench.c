@@ -0,0 +1,181 @@
+// Blend microbenchmark: checks blend(), blend_span() and blend_fill()
+// against the arithmetic reference below and compares their throughput.
+//
+//   cc -O2 -I.. -o blend_bench blend_bench.c ../blend.c ../graphics.c
+//
+// Add -mavx2 for the AVX2 kernels, -DTB_BLEND_NO_SIMD for the scalar ones
+// and -DTB_BLEND_LUT for lookup-table blending in blend() and the scalar
+// kernels.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "graphics.h"
+#include "blend.h"
+
+#define PIXELS (TB_SCREEN_WIDTH * TB_SCREEN_HEIGHT)
+#define ROUNDS 200
+#define REPEATS 7
+
+#if defined(__GNUC__)
+#define NOINLINE __attribute__((noinline))
+#else
+#define NOINLINE
+#endif
+
+static uint16_t src[PIXELS];
+static uint16_t dst[PIXELS];
+static uint16_t ref[PIXELS];
+
+static uint32_t rng_state = 0x12345678;
+
+static uint16_t next_pixel(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return (uint16_t)rng_state;
+}
+
+static double now_ms(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000.0 + t.tv_nsec / 1e6;
+}
+
+// The arithmetic blend() without TB_BLEND_LUT, kept out of line like a
+// call into graphics.c
+static NOINLINE void reference_blend(uint16_t* dst, uint16_t fg) {
+    uint8_t fg_r = fg & 0xF0;
+    uint8_t fg_g = (fg & 0x0F) << 4;
+    uint8_t fg_b = (fg >> 8) & 0xF0;
+    uint8_t fg_a = ((fg >> 8) & 0x0F) << 4;
+
+    if (fg_a == 0xF0) {
+        *dst = fg;
+        return;
+    }
+    if (fg_a == 0x00) {
+        return;
+    }
+
+    uint16_t bg = *dst;
+    uint8_t bg_r = bg & 0xF0;
+    uint8_t bg_g = (bg & 0x0F) << 4;
+    uint8_t bg_b = (bg >> 8) & 0xF0;
+    uint8_t bg_a = ((bg >> 8) & 0x0F) << 4;
+
+    uint8_t inverse_alpha = 0xF0 - fg_a;
+
+    uint8_t out_r = (fg_r * fg_a + bg_r * inverse_alpha) >> 8;
+    uint8_t out_g = (fg_g * fg_a + bg_g * inverse_alpha) >> 8;
+    uint8_t out_b = (fg_b * fg_a + bg_b * inverse_alpha) >> 8;
+    uint8_t out_a = fg_a + ((bg_a * inverse_alpha) >> 8);
+
+    *dst = pack_color(out_r, out_g, out_b, out_a);
+}
+
+// Every foreground pixel over a spread of backgrounds, and every fill
+// color with odd span lengths to exercise the kernel tails
+static int verify(void) {
+    static uint16_t out[PIXELS];
+    int errors = 0;
+
+    for (int round = 0; round < 64; round++) {
+        for (int i = 0; i < PIXELS; i++) {
+            dst[i] = next_pixel();
+        }
+        for (int base = 0; base < 65536; base += PIXELS) {
+            for (int i = 0; i < PIXELS; i++) {
+                src[i] = (uint16_t)(base + i);
+            }
+            memcpy(ref, dst, sizeof(ref));
+            for (int i = 0; i < PIXELS; i++) {
+                reference_blend(&ref[i], src[i]);
+            }
+            memcpy(out, dst, sizeof(out));
+            for (int i = 0; i < PIXELS; i++) {
+                blend(&out[i], src[i]);
+            }
+            errors += memcmp(out, ref, sizeof(out)) != 0;
+            memcpy(out, dst, sizeof(out));
+            blend_span(out, src, PIXELS);
+            errors += memcmp(out, ref, sizeof(out)) != 0;
+        }
+
+        uint16_t color = (uint16_t)(round * 1021 + 7);
+        for (int k = 0; k < 1024; k++, color += 64) {
+            int count = 1 + (int)(next_pixel() % 61);
+            memcpy(ref, dst, count * sizeof(uint16_t));
+            for (int i = 0; i < count; i++) {
+                reference_blend(&ref[i], color);
+            }
+            memcpy(out, dst, count * sizeof(uint16_t));
+            blend_fill(out, color, count);
+            errors += memcmp(out, ref, count * sizeof(uint16_t)) != 0;
+        }
+    }
+    return errors;
+}
+
+static void report(const char* name, double reference_ms, double blend_ms, double kernel_ms) {
+    double mpixels = (double)PIXELS * ROUNDS / 1e6;
+    printf("%-22s %8.1f %8.1f %8.1f Mpx/s   blend() %4.2fx   kernel %5.1fx\n", name,
+           mpixels / (reference_ms / 1000.0), mpixels / (blend_ms / 1000.0), mpixels / (kernel_ms / 1000.0),
+           reference_ms / blend_ms, reference_ms / kernel_ms);
+}
+
+// Time the reference, blend() and a kernel over the same work, best of
+// REPEATS; span is the length of the pixel runs and color, if not 0, is
+// blended instead of src
+static void run(const char* name, int span, uint16_t color) {
+    double best[3] = {0, 0, 0};
+    for (int repeat = 0; repeat < REPEATS; repeat++) {
+        for (int pass = 0; pass < 3; pass++) {
+            double start = now_ms();
+            for (int r = 0; r < ROUNDS; r++) {
+                for (int i = 0; i < PIXELS; i += span) {
+                    if (pass == 2) {
+                        if (color) {
+                            blend_fill(dst + i, color, span);
+                        } else {
+                            blend_span(dst + i, src + i, span);
+                        }
+                        continue;
+                    }
+                    for (int j = i; j < i + span; j++) {
+                        if (pass == 0) {
+                            reference_blend(&dst[j], color ? color : src[j]);
+                        } else {
+                            blend(&dst[j], color ? color : src[j]);
+                        }
+                    }
+                }
+            }
+            double elapsed = now_ms() - start;
+            if (repeat == 0 || elapsed < best[pass]) {
+                best[pass] = elapsed;
+            }
+        }
+    }
+    report(name, best[0], best[1], best[2]);
+}
+
+int main(void) {
+    int errors = verify();
+    printf("kernels: %s, mismatches: %d\n\n", blend_kernels(), errors);
+
+    // mixed alpha: pixels take the blending path or one of the shortcuts
+    for (int i = 0; i < PIXELS; i++) {
+        src[i] = next_pixel();
+        dst[i] = next_pixel();
+    }
+    printf("%-22s %8s %8s %8s\n", "", "ref", "blend()", "kernel");
+    run("rows, mixed alpha", TB_SCREEN_WIDTH, 0);
+    run("8-pixel spans", 8, 0);
+    run("fill rows, 50% alpha", TB_SCREEN_WIDTH, pack_color(0xC0, 0x40, 0x80, 0x80));
+    run("fill 4-pixel runs", 4, pack_color(0xC0, 0x40, 0x80, 0x80));
+
+    return errors != 0;
+}
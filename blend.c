@@ -0,0 +1,207 @@
+#include "blend.h"
+
+#include <string.h>
+
+// RGBA4444 "over" blending, bit-exact with blend() in graphics.c. Per
+// 4-bit channel, with alpha a and ia = 15 - a:
+//
+//   color = (fg * a + bg * ia) >> 4
+//   alpha = a + ((bg_alpha * ia) >> 4)
+//
+// except that a = 15 takes fg and a = 0 keeps bg. Each product sum is at
+// most 225, so two channels share a 16-bit lane, one per byte: red/blue
+// from (p >> 4) & 0x0F0F and green/alpha from p & 0x0F0F. A pixel then
+// costs two multiplies, and a vector of pixels two vector multiplies.
+
+#if !defined(TB_BLEND_NO_SIMD) && defined(__AVX2__)
+#include <immintrin.h>
+#define BLEND_SIMD "avx2"
+#define LANES 16
+typedef __m256i vec;
+#define V_LOAD(p)         _mm256_loadu_si256((const __m256i*)(p))
+#define V_STORE(p, v)     _mm256_storeu_si256((__m256i*)(p), v)
+#define V_SET(x)          _mm256_set1_epi16((short)(x))
+#define V_AND             _mm256_and_si256
+#define V_OR              _mm256_or_si256
+#define V_ADD             _mm256_add_epi16
+#define V_SUB             _mm256_sub_epi16
+#define V_MUL             _mm256_mullo_epi16
+#define V_SHR             _mm256_srli_epi16
+#define V_SHL             _mm256_slli_epi16
+#define V_EQ              _mm256_cmpeq_epi16
+#define V_SELECT(m, a, b) _mm256_blendv_epi8(b, a, m)
+#elif !defined(TB_BLEND_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64))
+#include <emmintrin.h>
+#define BLEND_SIMD "sse2"
+#define LANES 8
+typedef __m128i vec;
+#define V_LOAD(p)         _mm_loadu_si128((const __m128i*)(p))
+#define V_STORE(p, v)     _mm_storeu_si128((__m128i*)(p), v)
+#define V_SET(x)          _mm_set1_epi16((short)(x))
+#define V_AND             _mm_and_si128
+#define V_OR              _mm_or_si128
+#define V_ADD             _mm_add_epi16
+#define V_SUB             _mm_sub_epi16
+#define V_MUL             _mm_mullo_epi16
+#define V_SHR             _mm_srli_epi16
+#define V_SHL             _mm_slli_epi16
+#define V_EQ              _mm_cmpeq_epi16
+#define V_SELECT(m, a, b) _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b))
+#elif !defined(TB_BLEND_NO_SIMD) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#include <arm_neon.h>
+#define BLEND_SIMD "neon"
+#define LANES 8
+typedef uint16x8_t vec;
+#define V_LOAD(p)         vld1q_u16(p)
+#define V_STORE(p, v)     vst1q_u16(p, v)
+#define V_SET(x)          vdupq_n_u16(x)
+#define V_AND             vandq_u16
+#define V_OR              vorrq_u16
+#define V_ADD             vaddq_u16
+#define V_SUB             vsubq_u16
+#define V_MUL             vmulq_u16
+#define V_SHR             vshrq_n_u16
+#define V_SHL             vshlq_n_u16
+#define V_EQ              vceqq_u16
+#define V_SELECT(m, a, b) vbslq_u16(m, a, b)
+#endif
+
+#ifdef TB_BLEND_LUT
+#define LUT1(a, f, b) (uint8_t)(((f) * (a) + (b) * (15 - (a))) >> 4)
+#define LUT16(a, f) \
+    LUT1(a, f, 0), LUT1(a, f, 1), LUT1(a, f, 2), LUT1(a, f, 3), \
+    LUT1(a, f, 4), LUT1(a, f, 5), LUT1(a, f, 6), LUT1(a, f, 7), \
+    LUT1(a, f, 8), LUT1(a, f, 9), LUT1(a, f, 10), LUT1(a, f, 11), \
+    LUT1(a, f, 12), LUT1(a, f, 13), LUT1(a, f, 14), LUT1(a, f, 15)
+#define LUT256(a) { \
+    LUT16(a, 0), LUT16(a, 1), LUT16(a, 2), LUT16(a, 3), \
+    LUT16(a, 4), LUT16(a, 5), LUT16(a, 6), LUT16(a, 7), \
+    LUT16(a, 8), LUT16(a, 9), LUT16(a, 10), LUT16(a, 11), \
+    LUT16(a, 12), LUT16(a, 13), LUT16(a, 14), LUT16(a, 15) }
+
+const uint8_t blend_lut[16][256] = {
+    LUT256(0), LUT256(1), LUT256(2), LUT256(3),
+    LUT256(4), LUT256(5), LUT256(6), LUT256(7),
+    LUT256(8), LUT256(9), LUT256(10), LUT256(11),
+    LUT256(12), LUT256(13), LUT256(14), LUT256(15),
+};
+
+static inline uint16_t blend_pixel(uint16_t bg, uint16_t fg) {
+    return blend_lut_pixel(bg, fg);
+}
+#else
+static inline uint16_t blend_pixel(uint16_t bg, uint16_t fg) {
+    unsigned a = (fg >> 8) & 0x0F;
+    if (a == 0x0F) return fg;
+    if (a == 0) return bg;
+
+    unsigned ia = 15 - a;
+    unsigned rb = ((((fg >> 4) & 0x0F0F) * a + ((bg >> 4) & 0x0F0F) * ia) >> 4) & 0x0F0F;
+    unsigned ga = (((fg & 0x000F) * a + (bg & 0x0F0F) * ia) >> 4) & 0x0F0F;
+    return (uint16_t)((rb << 4 | ga) + (a << 8));
+}
+#endif
+
+#ifdef BLEND_SIMD
+static inline vec blend_vec(vec bg, vec fg) {
+    const vec pairs = V_SET(0x0F0F);
+    const vec nibble = V_SET(0x000F);
+    const vec full = V_SET(15);
+
+    vec a = V_AND(V_SHR(fg, 8), nibble);
+    vec ia = V_SUB(full, a);
+    vec rb = V_ADD(V_MUL(V_AND(V_SHR(fg, 4), pairs), a), V_MUL(V_AND(V_SHR(bg, 4), pairs), ia));
+    vec ga = V_ADD(V_MUL(V_AND(fg, nibble), a), V_MUL(V_AND(bg, pairs), ia));
+    rb = V_AND(V_SHR(rb, 4), pairs);
+    ga = V_AND(V_SHR(ga, 4), pairs);
+
+    vec out = V_ADD(V_OR(V_SHL(rb, 4), ga), V_SHL(a, 8));
+    out = V_SELECT(V_EQ(a, full), fg, out);
+    return V_SELECT(V_EQ(a, V_SET(0)), bg, out);
+}
+#endif
+
+// Blend count source pixels over dst
+void blend_span(uint16_t* dst, const uint16_t* src, int count) {
+    int i = 0;
+#ifdef BLEND_SIMD
+    for (; i + LANES <= count; i += LANES) {
+        V_STORE(dst + i, blend_vec(V_LOAD(dst + i), V_LOAD(src + i)));
+    }
+    if (count - i > 2) {
+        // the tail goes through one padded vector
+        uint16_t tail_dst[LANES] = {0}, tail_src[LANES] = {0};
+        memcpy(tail_dst, dst + i, (count - i) * sizeof(uint16_t));
+        memcpy(tail_src, src + i, (count - i) * sizeof(uint16_t));
+        V_STORE(tail_dst, blend_vec(V_LOAD(tail_dst), V_LOAD(tail_src)));
+        memcpy(dst + i, tail_dst, (count - i) * sizeof(uint16_t));
+        return;
+    }
+#endif
+    for (; i < count; i++) {
+        dst[i] = blend_pixel(dst[i], src[i]);
+    }
+}
+
+// Blend one color over count dst pixels
+void blend_fill(uint16_t* dst, uint16_t color, int count) {
+    unsigned a = (color >> 8) & 0x0F;
+    if (a == 0) return;
+    if (a == 0x0F) {
+        for (int i = 0; i < count; i++) {
+            dst[i] = color;
+        }
+        return;
+    }
+
+    // the color's share of each pixel is the same for the whole span
+    int i = 0;
+#ifdef BLEND_SIMD
+    const vec pairs = V_SET(0x0F0F);
+    const vec rb_fg = V_SET(((color >> 4) & 0x0F0F) * a);
+    const vec ga_fg = V_SET((color & 0x000F) * a);
+    const vec ia = V_SET(15 - a);
+    const vec alpha = V_SET(a << 8);
+    for (; i + LANES <= count; i += LANES) {
+        vec bg = V_LOAD(dst + i);
+        vec rb = V_AND(V_SHR(V_ADD(rb_fg, V_MUL(V_AND(V_SHR(bg, 4), pairs), ia)), 4), pairs);
+        vec ga = V_AND(V_SHR(V_ADD(ga_fg, V_MUL(V_AND(bg, pairs), ia)), 4), pairs);
+        V_STORE(dst + i, V_ADD(V_OR(V_SHL(rb, 4), ga), alpha));
+    }
+#endif
+
+#ifdef TB_BLEND_LUT
+    const uint8_t* lut = blend_lut[a];
+    const uint8_t* lut_r = lut + (color & 0xF0);
+    const uint8_t* lut_g = lut + ((color & 0x0F) << 4);
+    const uint8_t* lut_b = lut + ((color >> 8) & 0xF0);
+    for (; i < count; i++) {
+        unsigned bg = dst[i];
+        dst[i] = (uint16_t)(lut_r[(bg >> 4) & 0x0F] << 4 | lut_g[bg & 0x0F] | lut_b[bg >> 12] << 12
+                            | (a + lut[(bg >> 8) & 0x0F]) << 8);
+    }
+#else
+    unsigned rb_color = ((color >> 4) & 0x0F0F) * a;
+    unsigned ga_color = (color & 0x000F) * a;
+    unsigned inverse = 15 - a;
+    for (; i < count; i++) {
+        unsigned bg = dst[i];
+        unsigned rb = ((rb_color + ((bg >> 4) & 0x0F0F) * inverse) >> 4) & 0x0F0F;
+        unsigned ga = ((ga_color + (bg & 0x0F0F) * inverse) >> 4) & 0x0F0F;
+        dst[i] = (uint16_t)((rb << 4 | ga) + (a << 8));
+    }
+#endif
+}
+
+// Name of the kernels compiled in
+const char* blend_kernels(void) {
+#if defined(BLEND_SIMD) && defined(TB_BLEND_LUT)
+    return BLEND_SIMD ", lut scalar";
+#elif defined(BLEND_SIMD)
+    return BLEND_SIMD;
+#elif defined(TB_BLEND_LUT)
+    return "lut scalar";
+#else
+    return "scalar";
+#endif
+}
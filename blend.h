@@ -0,0 +1,33 @@
+#ifndef BLEND_H
+#define BLEND_H
+
+#include <stdint.h>
+
+// Span versions of blend(): the same result on every pixel, vectorized when
+// the compiler targets AVX2, SSE2 or NEON (define TB_BLEND_NO_SIMD to force
+// the scalar kernels)
+void blend_span(uint16_t* dst, const uint16_t* src, int count);
+void blend_fill(uint16_t* dst, uint16_t color, int count);
+const char* blend_kernels(void);
+
+#ifdef TB_BLEND_LUT
+// blend_lut[a][f << 4 | b] = (f * a + b * (15 - a)) >> 4 for 4-bit channels,
+// so scalar blending needs lookups instead of multiplies (for cores
+// without a fast multiplier)
+extern const uint8_t blend_lut[16][256];
+
+static inline uint16_t blend_lut_pixel(uint16_t bg, uint16_t fg) {
+    unsigned a = (fg >> 8) & 0x0F;
+    if (a == 0x0F) return fg;
+    if (a == 0) return bg;
+
+    const uint8_t* lut = blend_lut[a];
+    unsigned r = lut[(fg & 0xF0) | ((bg >> 4) & 0x0F)];
+    unsigned g = lut[(fg & 0x0F) << 4 | (bg & 0x0F)];
+    unsigned b = lut[((fg >> 8) & 0xF0) | (bg >> 12)];
+    unsigned alpha = a + lut[(bg >> 8) & 0x0F];
+    return (uint16_t)(r << 4 | g | b << 12 | alpha << 8);
+}
+#endif
+
+#endif
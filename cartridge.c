@@ -1,27 +1,22 @@
+// gmtime_r() is POSIX, not C11
+#define _POSIX_C_SOURCE 200112L
+
 #include "cartridge.h"
 
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
 
-int (*gamecount_func)();
-void (*gameload_func)(int index);
-
 #include "lua/lua.h"
 #include "lua/lualib.h"
 #include "lua/lauxlib.h"
 
 #include "pngle/pngle.h"
+#include "pngle/miniz.h"
 #include "tinybit.h"
 #include "memory.h"
-#include "lua_functions.h"  // extern log_func
-
-static size_t cartridge_index = 0;
-static pngle_t *pngle;
-static int pending_gameload = -1;
-
-static struct TinyBitHeader header;
-static bool header_parsed = false;
+#include "lua_functions.h"  // tb_ctx
+#include "chunk_cache.h"    // write_chunk
 
 static uint16_t read_u16_le(const uint8_t* p) {
     return (uint16_t)p[0] | ((uint16_t)p[1] << 8);
@@ -34,88 +29,101 @@ static uint32_t read_u32_le(const uint8_t* p) {
          | ((uint32_t)p[3] << 24);
 }
 
-static void log_line(const char* s) {
-    if (log_func) {
-        log_func(s);
+static void log_line(tinybit_ctx* ctx, const char* s) {
+    if (ctx->log_func) {
+        ctx->log_func(ctx, s);
     }
 }
 
-static void parse_and_log_header(void) {
-    const uint8_t* h = tinybit_memory->header;
-    header.format_version = read_u16_le(&h[0]);
-    header.flags          = read_u16_le(&h[2]);
-    header.script_size    = read_u32_le(&h[4]);
-    header.checksum       = read_u32_le(&h[8]);
-    memcpy(header.title,   &h[12], TB_HEADER_TITLE_SIZE);
-    memcpy(header.author,  &h[76], TB_HEADER_AUTHOR_SIZE);
-    header.title[TB_HEADER_TITLE_SIZE - 1]   = '\0';
-    header.author[TB_HEADER_AUTHOR_SIZE - 1] = '\0';
-    header.game_version = read_u16_le(&h[140]);
-    header.package_date = read_u32_le(&h[142]);
-
-    if (!log_func) return;
+// gmtime() returns a pointer to shared static storage; use the reentrant variants
+static struct tm* gmtime_safe(const time_t* ts, struct tm* out) {
+#if defined(_WIN32)
+    return gmtime_s(out, ts) == 0 ? out : NULL;
+#else
+    return gmtime_r(ts, out);
+#endif
+}
 
-    time_t ts = (time_t)header.package_date;
-    struct tm* tm_info = gmtime(&ts);
+static void parse_and_log_header(tinybit_ctx* ctx) {
+    struct TinyBitHeader* header = &ctx->cartridge.header;
+    const uint8_t* h = ctx->memory->header;
+    header->format_version = read_u16_le(&h[0]);
+    header->flags          = read_u16_le(&h[2]);
+    header->script_size    = read_u32_le(&h[4]);
+    header->checksum       = read_u32_le(&h[8]);
+    memcpy(header->title,   &h[12], TB_HEADER_TITLE_SIZE);
+    memcpy(header->author,  &h[76], TB_HEADER_AUTHOR_SIZE);
+    header->title[TB_HEADER_TITLE_SIZE - 1]   = '\0';
+    header->author[TB_HEADER_AUTHOR_SIZE - 1] = '\0';
+    header->game_version = read_u16_le(&h[140]);
+    header->package_date = read_u32_le(&h[142]);
+
+    if (!ctx->log_func) return;
+
+    time_t ts = (time_t)header->package_date;
+    struct tm tm_buf;
+    struct tm* tm_info = gmtime_safe(&ts, &tm_buf);
     char date_str[32];
     if (tm_info == NULL || strftime(date_str, sizeof(date_str), "%Y-%m-%d %H:%M:%S UTC", tm_info) == 0) {
         date_str[0] = '\0';
     }
 
     char line[160];
-    log_line("[TinyBit] Cartridge header:\n");
-    snprintf(line, sizeof(line), "  title:          \"%s\"\n", header.title);           log_line(line);
-    snprintf(line, sizeof(line), "  author:         \"%s\"\n", header.author);          log_line(line);
-    snprintf(line, sizeof(line), "  game version:   %u\n", header.game_version);        log_line(line);
-    snprintf(line, sizeof(line), "  package date:   %u (%s)\n", header.package_date, date_str); log_line(line);
-    snprintf(line, sizeof(line), "  format version: %u\n", header.format_version);      log_line(line);
-    snprintf(line, sizeof(line), "  flags:          0x%04x\n", header.flags);           log_line(line);
-    snprintf(line, sizeof(line), "  script size:    %u bytes\n", header.script_size);   log_line(line);
-    snprintf(line, sizeof(line), "  checksum:       0x%08x (crc32)\n", header.checksum); log_line(line);
+    log_line(ctx, "[TinyBit] Cartridge header:\n");
+    snprintf(line, sizeof(line), "  title:          \"%s\"\n", header->title);           log_line(ctx, line);
+    snprintf(line, sizeof(line), "  author:         \"%s\"\n", header->author);          log_line(ctx, line);
+    snprintf(line, sizeof(line), "  game version:   %u\n", header->game_version);        log_line(ctx, line);
+    snprintf(line, sizeof(line), "  package date:   %u (%s)\n", header->package_date, date_str); log_line(ctx, line);
+    snprintf(line, sizeof(line), "  format version: %u\n", header->format_version);      log_line(ctx, line);
+    snprintf(line, sizeof(line), "  flags:          0x%04x\n", header->flags);           log_line(ctx, line);
+    snprintf(line, sizeof(line), "  script size:    %u bytes\n", header->script_size);   log_line(ctx, line);
+    snprintf(line, sizeof(line), "  checksum:       0x%08x (crc32)\n", header->checksum); log_line(ctx, line);
 }
 
 // Decode PNG pixel data and load game assets (header, spritesheet, script) into memory
 static void decode_pixel_load_game(pngle_t *pngle, uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint8_t rgba[4])
 {
-    if (!rgba || !tinybit_memory) {
+    tinybit_ctx* ctx = (tinybit_ctx*)pngle_get_user_data(pngle);
+    if (!rgba || !ctx || !ctx->memory) {
         return;
     }
 
     uint8_t decoded = (rgba[0] & 0x3) << 6 | (rgba[1] & 0x3) << 4 | (rgba[2] & 0x3) << 2 | (rgba[3] & 0x3) << 0;
 
     // header (first TB_HEADER_SIZE pixels) — written directly into memory
-    if (cartridge_index < TB_HEADER_SIZE) {
-        tinybit_memory->header[cartridge_index] = decoded;
-        cartridge_index++;
-        if (cartridge_index == TB_HEADER_SIZE && !header_parsed) {
-            parse_and_log_header();
-            header_parsed = true;
+    if (ctx->cartridge.index < TB_HEADER_SIZE) {
+        ctx->memory->header[ctx->cartridge.index] = decoded;
+        ctx->cartridge.index++;
+        if (ctx->cartridge.index == TB_HEADER_SIZE && !ctx->cartridge.header_parsed) {
+            parse_and_log_header(ctx);
+            ctx->cartridge.header_parsed = true;
         }
         return;
     }
 
-    size_t payload_index = cartridge_index - TB_HEADER_SIZE;
-    size_t spritesheet_bytes = sizeof(tinybit_memory->spritesheet);
+    size_t payload_index = ctx->cartridge.index - TB_HEADER_SIZE;
+    size_t spritesheet_bytes = sizeof(ctx->memory->spritesheet);
 
     // spritesheet data (byte-level access for steganography decoding)
     if (payload_index < spritesheet_bytes) {
-        ((uint8_t*)tinybit_memory->spritesheet)[payload_index] = decoded;
+        ((uint8_t*)ctx->memory->spritesheet)[payload_index] = decoded;
     }
     // source code
     else {
         size_t script_offset = payload_index - spritesheet_bytes;
         if (script_offset < TB_MEM_SCRIPT_SIZE) {
-            tinybit_memory->script[script_offset] = decoded;
+            ctx->memory->script[script_offset] = decoded;
         }
     }
 
-    cartridge_index++;
+    ctx->cartridge.index++;
 }
 
 // Decode PNG pixel data and load cover image into spritesheet memory
 static void decode_pixel_load_cover(pngle_t *pngle, uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint8_t rgba[4])
 {
-    if (!rgba || !tinybit_memory) {
+    tinybit_ctx* ctx = (tinybit_ctx*)pngle_get_user_data(pngle);
+    if (!rgba || !ctx || !ctx->memory) {
         return;
     }
 
@@ -124,23 +132,25 @@ static void decode_pixel_load_cover(pngle_t *pngle, uint32_t x, uint32_t y, uint
         if (pixel_offset < TB_MEM_DISPLAY_SIZE) {
             uint8_t rg = (rgba[0] & 0xF0) | ((rgba[1] >> 4) & 0x0F);
             uint8_t ba = (rgba[2] & 0xF0) | ((rgba[3] >> 4) & 0x0F);
-            tinybit_memory->spritesheet[pixel_offset] = (uint16_t)rg | ((uint16_t)ba << 8);
+            ctx->memory->spritesheet[pixel_offset] = (uint16_t)rg | ((uint16_t)ba << 8);
         }
     }
 }
 
 static int lua_gamecount(lua_State* L) {
-    if (!gamecount_func) {
+    tinybit_ctx* ctx = tb_ctx(L);
+    if (!ctx->gamecount_func) {
         return lua_error(L);
     }
 
-    int count = gamecount_func();
+    int count = ctx->gamecount_func(ctx);
     lua_pushinteger(L, count);
     return 1;
 }
 
 static int lua_gamecover(lua_State* L) {
-    if (!gameload_func) {
+    tinybit_ctx* ctx = tb_ctx(L);
+    if (!ctx->gameload_func) {
         return lua_error(L);
     }
 
@@ -151,18 +161,19 @@ static int lua_gamecover(lua_State* L) {
 
     int index = luaL_checkinteger(L, 1);
 
-    cartridge_reset();
-    pngle_reset(pngle);
-    pngle_set_draw_callback(pngle, decode_pixel_load_cover);
-    gameload_func(index);
+    cartridge_reset(ctx);
+    pngle_reset(ctx->cartridge.pngle);
+    pngle_set_draw_callback(ctx->cartridge.pngle, decode_pixel_load_cover);
+    ctx->gameload_func(ctx, index);
 
-    pngle_set_draw_callback(pngle, decode_pixel_load_game);
+    pngle_set_draw_callback(ctx->cartridge.pngle, decode_pixel_load_game);
 
     return 0;
 }
 
 static int lua_gameload(lua_State* L) {
-    if (!gameload_func) {
+    tinybit_ctx* ctx = tb_ctx(L);
+    if (!ctx->gameload_func) {
         return lua_error(L);
     }
 
@@ -171,55 +182,97 @@ static int lua_gameload(lua_State* L) {
         return lua_error(L);
     }
 
-    pending_gameload = luaL_checkinteger(L, 1);
+    ctx->cartridge.pending_gameload = luaL_checkinteger(L, 1);
     return 0;
 }
 
-bool cartridge_load_pending(void) {
-    if (pending_gameload < 0) {
+bool cartridge_load_pending(tinybit_ctx* ctx) {
+    if (ctx->cartridge.pending_gameload < 0) {
         return false;
     }
 
-    int index = pending_gameload;
-    pending_gameload = -1;
+    int index = ctx->cartridge.pending_gameload;
+    ctx->cartridge.pending_gameload = -1;
 
-    cartridge_reset();
-    pngle_reset(pngle);
-    pngle_set_draw_callback(pngle, decode_pixel_load_game);
-    gameload_func(index);
-    tinybit_restart();
+    cartridge_reset(ctx);
+    pngle_reset(ctx->cartridge.pngle);
+    pngle_set_draw_callback(ctx->cartridge.pngle, decode_pixel_load_game);
+    ctx->gameload_func(ctx, index);
+    tinybit_restart(ctx);
     return true;
 }
 
-void cartridge_init(void) {
-    pngle = pngle_init(tinybit_memory->pngle_data, TB_MEM_PNGLE_SIZE);
-    pngle_set_draw_callback(pngle, decode_pixel_load_game);
-    cartridge_reset();
+void cartridge_init(tinybit_ctx* ctx) {
+    ctx->cartridge.pngle = pngle_init(ctx->memory->pngle_data, TB_MEM_PNGLE_SIZE);
+    pngle_set_user_data(ctx->cartridge.pngle, ctx);
+    pngle_set_draw_callback(ctx->cartridge.pngle, decode_pixel_load_game);
+    ctx->cartridge.pending_gameload = -1;
+    cartridge_reset(ctx);
 }
 
-void cartridge_destroy(void) {
-    pngle_destroy(pngle);
+void cartridge_destroy(tinybit_ctx* ctx) {
+    pngle_destroy(ctx->cartridge.pngle);
 }
 
-void cartridge_reset(void) {
-    cartridge_index = 0;
-    header_parsed = false;
-    memset(&header, 0, sizeof(header));
-    // Header bytes in tinybit_memory->header are zeroed by memory_init()
+void cartridge_reset(tinybit_ctx* ctx) {
+    ctx->cartridge.index = 0;
+    ctx->cartridge.header_parsed = false;
+    memset(&ctx->cartridge.header, 0, sizeof(ctx->cartridge.header));
+    // Header bytes in ctx->memory->header are zeroed by memory_init()
     // on the next tinybit_init and overwritten by the next cartridge feed.
 }
 
-bool cartridge_feed(const uint8_t* buffer, size_t size) {
-    int rc = pngle_feed(pngle, buffer, size);
+bool cartridge_feed(tinybit_ctx* ctx, const uint8_t* buffer, size_t size) {
+    int rc = pngle_feed(ctx->cartridge.pngle, buffer, size);
     // Defend luaL_dostring against an over-eager encoder: ensure the
     // script region is always NUL-terminated regardless of what just
-    // got written into tinybit_memory->script.
-    tinybit_memory->script[TB_MEM_SCRIPT_SIZE - 1] = '\0';
+    // got written into ctx->memory->script.
+    ctx->memory->script[TB_MEM_SCRIPT_SIZE - 1] = '\0';
     return rc != -2;
 }
 
-const struct TinyBitHeader* cartridge_header(void) {
-    return header_parsed ? &header : NULL;
+const struct TinyBitHeader* cartridge_header(tinybit_ctx* ctx) {
+    return ctx->cartridge.header_parsed ? &ctx->cartridge.header : NULL;
+}
+
+// Size of the script to run, and whether it is a binary chunk: a cartridge
+// flagged TB_HEADER_FLAG_BYTECODE whose payload starts with Lua's binary
+// signature and matches the header checksum, since Lua doesn't verify
+// bytecode. Anything else is text, which also covers the launcher and the
+// error screen written over a bytecode cartridge's script.
+size_t cartridge_script(tinybit_ctx* ctx, bool* bytecode) {
+    const uint8_t* script = ctx->memory->script;
+    const struct TinyBitHeader* header = cartridge_header(ctx);
+
+    *bytecode = header && (header->flags & TB_HEADER_FLAG_BYTECODE)
+             && header->script_size < TB_MEM_SCRIPT_SIZE
+             && memcmp(script, LUA_SIGNATURE, sizeof(LUA_SIGNATURE) - 1) == 0
+             && (uint32_t)mz_crc32(MZ_CRC32_INIT, script, header->script_size) == header->checksum;
+    return *bytecode ? header->script_size : strlen((const char*)script);
+}
+
+// Compile source into a stripped binary chunk in out. Uses the context's
+// Lua state (and heap) for the compiler. Returns the chunk size, or 0 if
+// there is no Lua state (after tinybit_stop), the source has errors (passed
+// to the error callback) or the chunk is larger than capacity.
+size_t cartridge_compile(tinybit_ctx* ctx, const char* source, size_t size, uint8_t* out, size_t capacity) {
+    lua_State* L = ctx->L;
+    struct chunk_writer w = { out, capacity, 0 };
+
+    if (!L) {
+        return 0;
+    }
+
+    if (luaL_loadbufferx(L, source, size, "=script", "t") != LUA_OK) {
+        if (ctx->error_func) {
+            ctx->error_func(ctx, lua_tostring(L, -1), NULL);
+        }
+        lua_pop(L, 1);
+        return 0;
+    }
+    int status = lua_dump(L, write_chunk, &w, /*strip=*/1);
+    lua_pop(L, 1);
+    return status == 0 ? w.size : 0;
 }
 
 void cartridge_register_lua(lua_State* L) {
@@ -8,15 +8,14 @@
 #include "lua/lua.h"
 #include "tinybit.h"
 
-void cartridge_init(void);
-void cartridge_destroy(void);
-void cartridge_reset(void);
-bool cartridge_feed(const uint8_t* buffer, size_t size);
+void cartridge_init(tinybit_ctx* ctx);
+void cartridge_destroy(tinybit_ctx* ctx);
+void cartridge_reset(tinybit_ctx* ctx);
+bool cartridge_feed(tinybit_ctx* ctx, const uint8_t* buffer, size_t size);
 void cartridge_register_lua(lua_State* L);
-bool cartridge_load_pending(void);
-const struct TinyBitHeader* cartridge_header(void);
-
-extern int (*gamecount_func)();
-extern void (*gameload_func)(int index);
+bool cartridge_load_pending(tinybit_ctx* ctx);
+const struct TinyBitHeader* cartridge_header(tinybit_ctx* ctx);
+size_t cartridge_script(tinybit_ctx* ctx, bool* bytecode);
+size_t cartridge_compile(tinybit_ctx* ctx, const char* source, size_t size, uint8_t* out, size_t capacity);
 
 #endif
@@ -0,0 +1,133 @@
+#include "chunk_cache.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "lua/lua.h"
+#include "lua/lauxlib.h"
+#include "pngle/miniz.h"
+
+// Compiled text scripts, dumped with debug info into a host buffer and
+// keyed by the CRC-32 and size of their source. Chunks are packed from the
+// start of the buffer in entry order; making room evicts the least recently
+// used entries and slides the rest down, so space is never fragmented.
+// That costs a memmove, but only on a miss, which compiles anyway.
+
+// lua_dump writer into a chunk_writer; also used by cartridge_compile
+int write_chunk(lua_State* L, const void* data, size_t size, void* ud) {
+    struct chunk_writer* w = (struct chunk_writer*)ud;
+    (void)L;
+    if (w->out) {
+        if (size > w->capacity - w->size) {
+            return 1;
+        }
+        memcpy(w->out + w->size, data, size);
+    }
+    w->size += size;
+    return 0;
+}
+
+static void remove_entry(tinybit_ctx* ctx, int index) {
+    int count = ctx->chunk_cache.count;
+    memmove(&ctx->chunk_cache.entries[index], &ctx->chunk_cache.entries[index + 1],
+            (size_t)(count - index - 1) * sizeof(ctx->chunk_cache.entries[0]));
+    ctx->chunk_cache.count--;
+}
+
+static int least_recent(tinybit_ctx* ctx) {
+    int oldest = 0;
+    for (int i = 1; i < ctx->chunk_cache.count; i++) {
+        if (ctx->chunk_cache.entries[i].last_used < ctx->chunk_cache.entries[oldest].last_used) {
+            oldest = i;
+        }
+    }
+    return oldest;
+}
+
+// Pack the remaining chunks to the front; returns the first free offset
+static size_t compact(tinybit_ctx* ctx) {
+    size_t end = 0;
+    for (int i = 0; i < ctx->chunk_cache.count; i++) {
+        struct TinyBitChunkEntry* e = &ctx->chunk_cache.entries[i];
+        if (e->offset != end) {
+            memmove(ctx->chunk_cache.buffer + end, ctx->chunk_cache.buffer + e->offset, e->size);
+            e->offset = end;
+        }
+        end += e->size;
+    }
+    return end;
+}
+
+static size_t used_bytes(tinybit_ctx* ctx) {
+    size_t used = 0;
+    for (int i = 0; i < ctx->chunk_cache.count; i++) {
+        used += ctx->chunk_cache.entries[i].size;
+    }
+    return used;
+}
+
+// Dump the function on top of the stack into the cache
+static void insert(tinybit_ctx* ctx, lua_State* L, uint32_t crc, size_t source_size) {
+    struct chunk_writer w = { NULL, 0, 0 };
+
+    lua_dump(L, write_chunk, &w, /*strip=*/0);
+    if (w.size > ctx->chunk_cache.capacity) {
+        return;
+    }
+    while (ctx->chunk_cache.count == TB_CHUNK_CACHE_ENTRIES
+           || used_bytes(ctx) + w.size > ctx->chunk_cache.capacity) {
+        remove_entry(ctx, least_recent(ctx));
+    }
+
+    size_t offset = compact(ctx);
+    struct chunk_writer out = { ctx->chunk_cache.buffer + offset, w.size, 0 };
+    if (lua_dump(L, write_chunk, &out, /*strip=*/0) != 0 || out.size != w.size) {
+        return;
+    }
+
+    struct TinyBitChunkEntry* e = &ctx->chunk_cache.entries[ctx->chunk_cache.count++];
+    e->crc = crc;
+    e->source_size = (uint32_t)source_size;
+    e->offset = offset;
+    e->size = w.size;
+    e->last_used = ++ctx->chunk_cache.clock;
+}
+
+// Chunks are kept across tinybit_init(); a NULL buffer turns the cache off
+void chunk_cache_init(tinybit_ctx* ctx, void* buffer, size_t size) {
+    memset(&ctx->chunk_cache, 0, sizeof(ctx->chunk_cache));
+    if (buffer) {
+        ctx->chunk_cache.buffer = (uint8_t*)buffer;
+        ctx->chunk_cache.capacity = size;
+    }
+}
+
+// luaL_loadbuffer for a text script, through the cache: a hit loads the
+// stored chunk without compiling, a miss compiles and stores the result
+int chunk_cache_load(tinybit_ctx* ctx, lua_State* L, const char* script, size_t size) {
+    if (!ctx->chunk_cache.buffer) {
+        return luaL_loadbufferx(L, script, size, "=script", "t");
+    }
+
+    uint32_t crc = (uint32_t)mz_crc32(MZ_CRC32_INIT, (const unsigned char*)script, size);
+    for (int i = 0; i < ctx->chunk_cache.count; i++) {
+        struct TinyBitChunkEntry* e = &ctx->chunk_cache.entries[i];
+        if (e->crc == crc && e->source_size == size) {
+            e->last_used = ++ctx->chunk_cache.clock;
+            if (luaL_loadbufferx(L, (const char*)ctx->chunk_cache.buffer + e->offset, e->size, "=script", "b") == LUA_OK) {
+                ctx->chunk_cache.hits++;
+                return LUA_OK;
+            }
+            lua_pop(L, 1); // not a chunk this build can load; compile instead
+            remove_entry(ctx, i);
+            break;
+        }
+    }
+
+    ctx->chunk_cache.misses++;
+    int status = luaL_loadbufferx(L, script, size, "=script", "t");
+    if (status == LUA_OK) {
+        insert(ctx, L, crc, size);
+    }
+    return status;
+}
@@ -0,0 +1,22 @@
+#ifndef CHUNK_CACHE_H
+#define CHUNK_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "tinybit.h"
+
+struct lua_State;
+
+// lua_dump target: a buffer of capacity bytes, filled up to size
+struct chunk_writer {
+    uint8_t* out;   // NULL: only count
+    size_t capacity;
+    size_t size;
+};
+
+int write_chunk(struct lua_State* L, const void* data, size_t size, void* ud);
+void chunk_cache_init(tinybit_ctx* ctx, void* buffer, size_t size);
+int chunk_cache_load(tinybit_ctx* ctx, struct lua_State* L, const char* script, size_t size);
+
+#endif
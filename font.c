@@ -1,104 +1,104 @@
-#include <stdint.h>
-#include <string.h>
-
-#include "graphics.h"
-#include "memory.h"
-#include "font.h"
-#include "assets/basic_font.h"
-#include "tinybit.h"
-
-int cursorX = 0;
-int cursorY = 0;
-const int fontWidth = 4;
-const int fontHeight = 6;
-uint16_t textColor = 0xFFFF;
-
-char characters[16 * 8] = {
-	'?', '"', '%', '\'', '(', ')', '*', '+', ',', '-', '.', '/', '!',  ' ', ' ', ' ',
-	'0', '1', '2', '3', '4',  '5', '6', '7', '8', '9', ':', ';', '<', '=',  '>', '?',
-	'@', 'a', 'b', 'c',  'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l',  'm', 'n', 'o',
-	'p', 'q', 'r', 's',  't', 'u', 'v', 'w', 'x', 'y', 'z', '[', '\\', ']', '^', '_',
-	'`', 'A', 'B', 'C',  'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L',  'M', 'N', 'O',
-	'P', 'Q', 'R', 'S',  'T', 'U', 'V', 'W', 'X', 'Y', 'Z', '{', '|',  '}', ' ', ' ',
-	' ', ' ', ' ', ' ',  ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ',  ' ', ' ', ' ',
-	' ', ' ', ' ', ' ',  ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ',  ' ', ' ', ' '
-};
-
-// Reset all font state to defaults (called from tinybit_init)
-void font_init() {
-	cursorX = 0;
-	cursorY = 0;
-	textColor = 0xFFFF;
-}
-
-// Set the text color for font rendering
-void font_text_color(uint16_t color) {
-	textColor = color;
-}
-
-// Set the cursor position for text rendering
-void font_cursor(int x, int y) {
-	cursorX = x;
-	cursorY = y;
-}
-
-// Print text string at current cursor position using bitmap font
-void font_print(const char* str) {
-	const char* ptr = str;
-	int location = 0;
-
-	int startX = cursorX;
-
-	while (*ptr) {
-
-		// process newline character
-		if (*ptr == '\n') {
-			cursorY += fontHeight;
-			cursorX = startX;
-			ptr++;
-			continue;
-		}
-
-		// get character location
-		location = 0;
-		for (int i = 0; i < 16 * 8; i++) {
-			if (*ptr == characters[i]) {
-				location = i;
-				break; // Stop at the first match
-			}
-		}
-
-		// draw the character using direct pixel blending
-		int charRow = location / 16;
-		int charCol = location % 16;
-
-		for (int y = 0; y < fontHeight; y++) {
-			for (int x = 0; x < fontWidth; x++) {
-				int px = cursorX + x;
-				int py = cursorY + y;
-				
-				if (px >= 0 && px < TB_SCREEN_WIDTH && py >= 0 && py < TB_SCREEN_HEIGHT) {
-					int byteIndex = (charRow * (fontHeight+2)+y) * 16 + charCol;
-					
-					// Bounds check for font array access
-					if (byteIndex >= 0 && byteIndex < sizeof(basic_font)) {
-						int bitPosition = 7 - x;
-						uint8_t font_byte = basic_font[byteIndex];
-						uint16_t* pixel = &tinybit_memory->display[py * TB_SCREEN_WIDTH + px];
-
-						if ((font_byte >> bitPosition) & 1) {
-							blend(pixel, textColor);
-						}
-						else {
-							blend(pixel, fillColor);
-						}
-					}
-				}
-			}
-		}
-
-		cursorX += fontWidth;
-		ptr++;
-	}
-
+#include <stdint.h>
+#include <string.h>
+
+#include "graphics.h"
+#include "blend.h"
+#include "memory.h"
+#include "font.h"
+#include "assets/basic_font.h"
+#include "tinybit.h"
+
+const int fontWidth = 4;
+const int fontHeight = 6;
+
+const char characters[16 * 8] = {
+	'?', '"', '%', '\'', '(', ')', '*', '+', ',', '-', '.', '/', '!',  ' ', ' ', ' ',
+	'0', '1', '2', '3', '4',  '5', '6', '7', '8', '9', ':', ';', '<', '=',  '>', '?',
+	'@', 'a', 'b', 'c',  'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l',  'm', 'n', 'o',
+	'p', 'q', 'r', 's',  't', 'u', 'v', 'w', 'x', 'y', 'z', '[', '\\', ']', '^', '_',
+	'`', 'A', 'B', 'C',  'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L',  'M', 'N', 'O',
+	'P', 'Q', 'R', 'S',  'T', 'U', 'V', 'W', 'X', 'Y', 'Z', '{', '|',  '}', ' ', ' ',
+	' ', ' ', ' ', ' ',  ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ',  ' ', ' ', ' ',
+	' ', ' ', ' ', ' ',  ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ',  ' ', ' ', ' '
+};
+
+// Reset all font state to defaults (called from tinybit_init)
+void font_init(tinybit_ctx* ctx) {
+	ctx->font.cursorX = 0;
+	ctx->font.cursorY = 0;
+	ctx->font.textColor = 0xFFFF;
+}
+
+// Set the text color for font rendering
+void font_text_color(tinybit_ctx* ctx, uint16_t color) {
+	ctx->font.textColor = color;
+}
+
+// Set the cursor position for text rendering
+void font_cursor(tinybit_ctx* ctx, int x, int y) {
+	ctx->font.cursorX = x;
+	ctx->font.cursorY = y;
+}
+
+// Print text string at current cursor position using bitmap font
+void font_print(tinybit_ctx* ctx, const char* str) {
+	const char* ptr = str;
+	int location = 0;
+
+	int startX = ctx->font.cursorX;
+
+	while (*ptr) {
+
+		// process newline character
+		if (*ptr == '\n') {
+			ctx->font.cursorY += fontHeight;
+			ctx->font.cursorX = startX;
+			ptr++;
+			continue;
+		}
+
+		// get character location
+		location = 0;
+		for (int i = 0; i < 16 * 8; i++) {
+			if (*ptr == characters[i]) {
+				location = i;
+				break; // Stop at the first match
+			}
+		}
+
+		// draw the character as runs of text and background pixels
+		int charRow = location / 16;
+		int charCol = location % 16;
+		int fromX = ctx->font.cursorX < 0 ? -ctx->font.cursorX : 0;
+		int toX = ctx->font.cursorX + fontWidth > TB_SCREEN_WIDTH ? TB_SCREEN_WIDTH - ctx->font.cursorX : fontWidth;
+
+		for (int y = 0; y < fontHeight; y++) {
+			int py = ctx->font.cursorY + y;
+			int byteIndex = (charRow * (fontHeight+2)+y) * 16 + charCol;
+
+			// Bounds check for font array access
+			if (py < 0 || py >= TB_SCREEN_HEIGHT || fromX >= toX || byteIndex < 0 || byteIndex >= sizeof(basic_font)) {
+				continue;
+			}
+
+			uint8_t font_byte = basic_font[byteIndex];
+			// the row from the first visible column, indexed by x - fromX
+			uint16_t* row = &ctx->memory->display[py * TB_SCREEN_WIDTH + ctx->font.cursorX + fromX];
+
+			for (int x = fromX; x < toX;) {
+				int bit = (font_byte >> (7 - x)) & 1;
+				int end = x + 1;
+				while (end < toX && ((font_byte >> (7 - end)) & 1) == bit) {
+					end++;
+				}
+				blend_fill(&row[x - fromX], bit ? ctx->font.textColor : ctx->graphics.fillColor, end - x);
+				count_pixels(ctx, end - x);
+				x = end;
+			}
+		}
+
+		ctx->font.cursorX += fontWidth;
+		ptr++;
+	}
+
 }
\ No newline at end of file
@@ -1,16 +1,16 @@
-#ifndef FONT_H
-#define FONT_H
-
-extern int cursorX;
-extern int cursorY;
-extern uint16_t textColor;
-
-extern char characters[16 * 8];
-
-// Font function declarations
-void font_init();
-void font_cursor(int, int);
-void font_print(const char*);
-void font_text_color(uint16_t color);
-
+#ifndef FONT_H
+#define FONT_H
+
+#include <stdint.h>
+
+#include "tinybit.h"
+
+extern const char characters[16 * 8];
+
+// Font function declarations
+void font_init(tinybit_ctx* ctx);
+void font_cursor(tinybit_ctx* ctx, int, int);
+void font_print(tinybit_ctx* ctx, const char*);
+void font_text_color(tinybit_ctx* ctx, uint16_t color);
+
 #endif
\ No newline at end of file
@@ -1,468 +1,707 @@
-
-#include <time.h>
-#include <string.h>
-#include <stdint.h>
-#include <stdbool.h>
-#include <stdlib.h>
-
-#include "graphics.h"
-#include "memory.h"
-#include "tinybit.h"
-
-uint16_t fillColor = 0;
-uint16_t strokeColor = 0;
-int strokeWidth = 0;
-
-#define MAX_POLYGON_POINTS 32
-typedef struct {
-    int x, y;
-} Point;
-
-static Point polygon_points[MAX_POLYGON_POINTS];
-static int polygon_point_count = 0;
-
-static const int sin_table[] = {
-    0, 1143, 2287, 3429, 4571, 5711, 6850, 7986, 9120, 10252, 11380,
-    12504, 13625, 14742, 15854, 16961, 18064, 19160, 20251, 21336, 22414,
-    23486, 24550, 25606, 26655, 27696, 28729, 29752, 30767, 31772, 32768,
-    33753, 34728, 35693, 36647, 37589, 38521, 39440, 40347, 41243, 42125,
-    42995, 43852, 44695, 45525, 46340, 47142, 47929, 48702, 49460, 50203,
-    50931, 51643, 52339, 53019, 53683, 54331, 54963, 55577, 56175, 56755,
-    57319, 57864, 58393, 58903, 59395, 59870, 60326, 60763, 61183, 61583,
-    61965, 62328, 62672, 62997, 63302, 63589, 63856, 64103, 64331, 64540,
-    64729, 64898, 65047, 65176, 65286, 65376, 65446, 65496, 65526, 65536,
-};
-
-// Reset all graphics state to defaults (called from tinybit_init)
-void graphics_init() {
-    fillColor = 0;
-    strokeColor = 0;
-    strokeWidth = 0;
-    polygon_point_count = 0;
-}
-
-// Fast sine approximation using lookup table
-int fast_sin(int angle) {
-    angle = angle % 360;
-    if (angle < 0) angle += 360;
-
-    if (angle <= 90) return sin_table[angle];
-    else if (angle <= 180) return sin_table[180 - angle];
-    else if (angle <= 270) return -sin_table[angle - 180];
-    else return -sin_table[360 - angle];
-}
-
-// Fast cosine approximation using sine lookup table
-int fast_cos(int angle) {
-    return fast_sin(angle + 90);
-}
-
-// Alpha blend foreground pixel onto destination pixel
-// Pixel format: uint16_t where low byte = RRRRGGGG, high byte = BBBBAAAA
-void blend(uint16_t* dst, uint16_t fg) {
-    uint8_t fg_r = fg & 0xF0;
-    uint8_t fg_g = (fg & 0x0F) << 4;
-    uint8_t fg_b = (fg >> 8) & 0xF0;
-    uint8_t fg_a = ((fg >> 8) & 0x0F) << 4;
-
-    if (fg_a == 0xF0) {
-        *dst = fg;
-        return;
-    }
-    if (fg_a == 0x00) {
-        return;
-    }
-
-    uint16_t bg = *dst;
-    uint8_t bg_r = bg & 0xF0;
-    uint8_t bg_g = (bg & 0x0F) << 4;
-    uint8_t bg_b = (bg >> 8) & 0xF0;
-    uint8_t bg_a = ((bg >> 8) & 0x0F) << 4;
-
-    uint8_t inverse_alpha = 0xF0 - fg_a;
-
-    uint8_t out_r = (fg_r * fg_a + bg_r * inverse_alpha) >> 8;
-    uint8_t out_g = (fg_g * fg_a + bg_g * inverse_alpha) >> 8;
-    uint8_t out_b = (fg_b * fg_a + bg_b * inverse_alpha) >> 8;
-    uint8_t out_a = fg_a + ((bg_a * inverse_alpha) >> 8);
-
-    *dst = pack_color(out_r, out_g, out_b, out_a);
-}
-
-// Generate random integer within specified range
-int random_range(int min, int max) {
-    return min + rand() / (RAND_MAX / (max - min + 1) + 1);
-}
-
-// Draw a sprite from spritesheet to display with scaling and clipping
-void draw_sprite(int sourceX, int sourceY, int sourceW, int sourceH, int targetX, int targetY, int targetW, int targetH, TARGET target) {
-    uint16_t* src_buf;
-    if (target == TARGET_SPRITESHEET) {
-        src_buf = tinybit_memory->spritesheet;
-    } else {
-        src_buf = tinybit_memory->display;
-    }
-
-    int clipStartX = targetX < 0 ? -targetX : 0;
-    int clipStartY = targetY < 0 ? -targetY : 0;
-    int clipEndX = (targetX + targetW > TB_SCREEN_WIDTH) ? TB_SCREEN_WIDTH - targetX : targetW;
-    int clipEndY = (targetY + targetH > TB_SCREEN_HEIGHT) ? TB_SCREEN_HEIGHT - targetY : targetH;
-
-    if (clipStartX >= clipEndX || clipStartY >= clipEndY) return;
-
-    int scale_x_fixed_point = (sourceW << 16) / targetW;
-    int scale_y_fixed_point = (sourceH << 16) / targetH;
-
-    uint16_t* dst = tinybit_memory->display + (targetY + clipStartY) * TB_SCREEN_WIDTH + targetX + clipStartX;
-
-    for (int y = clipStartY; y < clipEndY; ++y) {
-        int sourcePixelY = sourceY + ((y * scale_y_fixed_point) >> 16);
-
-        if (sourcePixelY < 0 || sourcePixelY >= TB_SCREEN_HEIGHT) {
-            dst += TB_SCREEN_WIDTH;
-            continue;
-        }
-
-        uint16_t* src_row = src_buf + sourcePixelY * TB_SCREEN_WIDTH;
-
-        for (int x = clipStartX; x < clipEndX; ++x) {
-            int sourcePixelX = sourceX + ((x * scale_x_fixed_point) >> 16);
-            if (sourcePixelX >= 0 && sourcePixelX < TB_SCREEN_WIDTH) {
-                blend(dst, src_row[sourcePixelX]);
-            }
-            dst++;
-        }
-        dst += TB_SCREEN_WIDTH - (clipEndX - clipStartX);
-    }
-}
-
-// Draw a rotated sprite from spritesheet to display with scaling and clipping
-void draw_sprite_rotated(int sourceX, int sourceY, int sourceW, int sourceH, int targetX, int targetY, int targetW, int targetH, int angleDegrees, TARGET target) {
-    uint16_t* src_buf;
-    if (target == TARGET_SPRITESHEET) {
-        src_buf = tinybit_memory->spritesheet;
-    } else {
-        src_buf = tinybit_memory->display;
-    }
-
-    int cosA = fast_cos(angleDegrees);
-    int sinA = fast_sin(angleDegrees);
-
-    int centerX = targetW >> 1;
-    int centerY = targetH >> 1;
-
-    // Calculate expanded bounds for rotated sprite to prevent clipping
-    int absCosSin = (abs(cosA) + abs(sinA)) >> 16;
-    if (absCosSin == 0) absCosSin = 1;
-
-    int expandedW = (targetW * absCosSin) + targetW;
-    int expandedH = (targetH * absCosSin) + targetH;
-
-    int expandX = (expandedW - targetW) >> 1;
-    int expandY = (expandedH - targetH) >> 1;
-
-    int clipStartX = (targetX - expandX) < 0 ? -(targetX - expandX) : 0;
-    int clipStartY = (targetY - expandY) < 0 ? -(targetY - expandY) : 0;
-    int clipEndX = (targetX - expandX + expandedW > TB_SCREEN_WIDTH) ? TB_SCREEN_WIDTH - (targetX - expandX) : expandedW;
-    int clipEndY = (targetY - expandY + expandedH > TB_SCREEN_HEIGHT) ? TB_SCREEN_HEIGHT - (targetY - expandY) : expandedH;
-
-    if (clipStartX >= clipEndX || clipStartY >= clipEndY) return;
-
-    int scale_x_fixed_point = (sourceW << 16) / targetW;
-    int scale_y_fixed_point = (sourceH << 16) / targetH;
-
-    uint16_t* display = tinybit_memory->display;
-
-    for (int y = clipStartY; y < clipEndY; ++y) {
-        for (int x = clipStartX; x < clipEndX; ++x) {
-            int screenX = targetX - expandX + x;
-            int screenY = targetY - expandY + y;
-
-            if (screenX < 0 || screenX >= TB_SCREEN_WIDTH || screenY < 0 || screenY >= TB_SCREEN_HEIGHT) continue;
-
-            int relX = x - expandX - centerX;
-            int relY = y - expandY - centerY;
-
-            int rotX = ((relX * cosA + relY * sinA) >> 16) + centerX;
-            int rotY = ((-relX * sinA + relY * cosA) >> 16) + centerY;
-
-            if (rotX >= 0 && rotX < targetW && rotY >= 0 && rotY < targetH) {
-                int sourcePixelX = sourceX + ((rotX * scale_x_fixed_point) >> 16);
-                int sourcePixelY = sourceY + ((rotY * scale_y_fixed_point) >> 16);
-
-                if (sourcePixelX >= 0 && sourcePixelX < TB_SCREEN_WIDTH &&
-                    sourcePixelY >= 0 && sourcePixelY < TB_SCREEN_HEIGHT) {
-
-                    blend(&display[screenY * TB_SCREEN_WIDTH + screenX],
-                          src_buf[sourcePixelY * TB_SCREEN_WIDTH + sourcePixelX]);
-                }
-            }
-        }
-    }
-}
-
-// Draw a rectangle with optional stroke and fill
-void draw_rect(int x, int y, int w, int h) {
-    int clipX = x < 0 ? 0 : x;
-    int clipY = y < 0 ? 0 : y;
-    int clipW = (x + w > TB_SCREEN_WIDTH) ? TB_SCREEN_WIDTH - x : w;
-    int clipH = (y + h > TB_SCREEN_HEIGHT) ? TB_SCREEN_HEIGHT - y : h;
-
-    if (clipX >= TB_SCREEN_WIDTH || clipY >= TB_SCREEN_HEIGHT || clipW <= 0 || clipH <= 0) return;
-
-    uint16_t* display = tinybit_memory->display;
-
-    if (strokeWidth > 0) {
-        for (int i = 0; i < strokeWidth && i < clipH; i++) {
-            for (int j = 0; j < clipW; j++) {
-                blend(&display[(clipY + i) * TB_SCREEN_WIDTH + clipX + j], strokeColor);
-                if (clipH - 1 - i != i) {
-                    blend(&display[(clipY + clipH - 1 - i) * TB_SCREEN_WIDTH + clipX + j], strokeColor);
-                }
-            }
-        }
-
-        for (int j = strokeWidth; j < clipH - strokeWidth; j++) {
-            for (int i = 0; i < strokeWidth && i < clipW; i++) {
-                blend(&display[(clipY + j) * TB_SCREEN_WIDTH + clipX + i], strokeColor);
-                if (clipW - 1 - i != i) {
-                    blend(&display[(clipY + j) * TB_SCREEN_WIDTH + clipX + clipW - 1 - i], strokeColor);
-                }
-            }
-        }
-    }
-
-    int fillStartX = strokeWidth;
-    int fillStartY = strokeWidth;
-    int fillW = clipW - 2 * strokeWidth;
-    int fillH = clipH - 2 * strokeWidth;
-
-    if (fillW > 0 && fillH > 0) {
-        for (int j = 0; j < fillH; j++) {
-            for (int i = 0; i < fillW; i++) {
-                blend(&display[(clipY + fillStartY + j) * TB_SCREEN_WIDTH + clipX + fillStartX + i], fillColor);
-            }
-        }
-    }
-}
-
-// Draw an oval with optional stroke and fill
-void draw_oval(int x, int y, int w, int h) {
-    int rx = w >> 1;
-    int ry = h >> 1;
-    int rx2 = rx * rx;
-    int ry2 = ry * ry;
-
-    int strokeRx = rx - strokeWidth;
-    int strokeRy = ry - strokeWidth;
-    int strokeRx2 = strokeRx * strokeRx;
-    int strokeRy2 = strokeRy * strokeRy;
-
-    uint16_t* display = tinybit_memory->display;
-
-    for (int j = 0; j < h; j++) {
-        int dy = j - ry;
-        int dy2 = dy * dy;
-
-        for (int i = 0; i < w; i++) {
-            int px = x + i;
-            int py = y + j;
-
-            if (px < 0 || px >= TB_SCREEN_WIDTH || py < 0 || py >= TB_SCREEN_HEIGHT) continue;
-
-            int dx = i - rx;
-            int dx2 = dx * dx;
-
-            int outer_test = dx2 * ry2 + dy2 * rx2;
-
-            if (outer_test <= rx2 * ry2) {
-                if (strokeWidth > 0 && strokeRx > 0 && strokeRy > 0) {
-                    int inner_test = dx2 * strokeRy2 + dy2 * strokeRx2;
-                    if (inner_test > strokeRx2 * strokeRy2) {
-                        blend(&display[py * TB_SCREEN_WIDTH + px], strokeColor);
-                    }
-                    else {
-                        blend(&display[py * TB_SCREEN_WIDTH + px], fillColor);
-                    }
-                }
-                else {
-                    blend(&display[py * TB_SCREEN_WIDTH + px], fillColor);
-                }
-            }
-        }
-    }
-}
-
-// Set stroke color and width for drawing operations
-void set_stroke(int width, uint16_t color) {
-    strokeWidth = width >= 0 ? width : 0;
-    strokeColor = color;
-}
-
-// Set fill color for drawing operations
-void set_fill(uint16_t color) {
-    fillColor = color;
-}
-
-// Draw a single pixel at specified coordinates
-void draw_pixel(int x, int y) {
-    if (x < 0 || x >= TB_SCREEN_WIDTH || y < 0 || y >= TB_SCREEN_HEIGHT) {
-        return;
-    }
-    uint16_t* display = tinybit_memory->display;
-    blend(&display[y * TB_SCREEN_WIDTH + x], fillColor);
-}
-
-// Set a pixel at specified coordinates to a specific color
-void pset(int x, int y, uint16_t color) {
-    if (x < 0 || x >= TB_SCREEN_WIDTH || y < 0 || y >= TB_SCREEN_HEIGHT) {
-        return;
-    }
-    uint16_t* display = tinybit_memory->display;
-    display[y * TB_SCREEN_WIDTH + x] = color;
-}
-
-// Get the color of a pixel at specified coordinates
-uint16_t pget(int x, int y) {
-    if (x < 0 || x >= TB_SCREEN_WIDTH || y < 0 || y >= TB_SCREEN_HEIGHT) {
-        return 0;
-    }
-    uint16_t* display = tinybit_memory->display;
-    return display[y * TB_SCREEN_WIDTH + x];
-}
-
-// Draw a line between two points using Bresenham's algorithm
-void draw_line(int x1, int y1, int x2, int y2) {
-    if (strokeWidth <= 0) return;
-
-    uint16_t* display = tinybit_memory->display;
-
-    int dx = abs(x2 - x1);
-    int dy = abs(y2 - y1);
-    int sx = x1 < x2 ? 1 : -1;
-    int sy = y1 < y2 ? 1 : -1;
-    int err = dx - dy;
-
-    int x = x1;
-    int y = y1;
-
-    while (1) {
-        if (strokeWidth == 1) {
-            if (x >= 0 && x < TB_SCREEN_WIDTH && y >= 0 && y < TB_SCREEN_HEIGHT) {
-                blend(&display[y * TB_SCREEN_WIDTH + x], strokeColor);
-            }
-        } else {
-            int radius = strokeWidth >> 1;
-            for (int dy = -radius; dy <= radius; dy++) {
-                for (int dx = -radius; dx <= radius; dx++) {
-                    int px = x + dx;
-                    int py = y + dy;
-                    if (px >= 0 && px < TB_SCREEN_WIDTH && py >= 0 && py < TB_SCREEN_HEIGHT) {
-                        blend(&display[py * TB_SCREEN_WIDTH + px], strokeColor);
-                    }
-                }
-            }
-        }
-
-        if (x == x2 && y == y2) break;
-
-        int e2 = 2 * err;
-        if (e2 > -dy) {
-            err -= dy;
-            x += sx;
-        }
-        if (e2 < dx) {
-            err += dx;
-            y += sy;
-        }
-    }
-}
-
-// Clear the display buffer (set all pixels to black/transparent)
-void draw_cls() {
-    memset(tinybit_memory->display, 0, sizeof(tinybit_memory->display));
-}
-
-// Add a point to the polygon vertex list
-void poly_add(int x, int y) {
-    if (polygon_point_count < MAX_POLYGON_POINTS) {
-        polygon_points[polygon_point_count].x = x;
-        polygon_points[polygon_point_count].y = y;
-        polygon_point_count++;
-    }
-}
-
-// Clear the polygon vertex list
-void poly_clear() {
-    polygon_point_count = 0;
-}
-
-// Draw a filled polygon using the current vertex list with optional stroke
-void draw_polygon() {
-    if (polygon_point_count < 3) return;
-
-    uint16_t* display = tinybit_memory->display;
-
-    int minY = polygon_points[0].y;
-    int maxY = polygon_points[0].y;
-
-    for (int i = 1; i < polygon_point_count; i++) {
-        if (polygon_points[i].y < minY) minY = polygon_points[i].y;
-        if (polygon_points[i].y > maxY) maxY = polygon_points[i].y;
-    }
-
-    if (minY >= TB_SCREEN_HEIGHT || maxY < 0) return;
-
-    minY = minY < 0 ? 0 : minY;
-    maxY = maxY >= TB_SCREEN_HEIGHT ? TB_SCREEN_HEIGHT - 1 : maxY;
-
-    for (int y = minY; y <= maxY; y++) {
-        int intersections[MAX_POLYGON_POINTS];
-        int intersectionCount = 0;
-
-        for (int i = 0; i < polygon_point_count; i++) {
-            int j = (i + 1) % polygon_point_count;
-            int y1 = polygon_points[i].y;
-            int y2 = polygon_points[j].y;
-
-            if ((y1 <= y && y2 > y) || (y2 <= y && y1 > y)) {
-                int x1 = polygon_points[i].x;
-                int x2 = polygon_points[j].x;
-                int x = x1 + ((y - y1) * (x2 - x1)) / (y2 - y1);
-                intersections[intersectionCount++] = x;
-            }
-        }
-
-        for (int i = 0; i < intersectionCount - 1; i++) {
-            for (int j = i + 1; j < intersectionCount; j++) {
-                if (intersections[i] > intersections[j]) {
-                    int temp = intersections[i];
-                    intersections[i] = intersections[j];
-                    intersections[j] = temp;
-                }
-            }
-        }
-
-        for (int i = 0; i < intersectionCount; i += 2) {
-            if (i + 1 < intersectionCount) {
-                int x1 = intersections[i];
-                int x2 = intersections[i + 1];
-
-                x1 = x1 < 0 ? 0 : x1;
-                x2 = x2 >= TB_SCREEN_WIDTH ? TB_SCREEN_WIDTH - 1 : x2;
-
-                for (int x = x1; x <= x2; x++) {
-                    blend(&display[y * TB_SCREEN_WIDTH + x], fillColor);
-                }
-            }
-        }
-    }
-
-    if (strokeWidth > 0) {
-        for (int i = 0; i < polygon_point_count; i++) {
-            int j = (i + 1) % polygon_point_count;
-            draw_line(polygon_points[i].x, polygon_points[i].y,
-                     polygon_points[j].x, polygon_points[j].y);
-        }
-    }
-}
+
+#include <time.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <limits.h>
+
+#include "graphics.h"
+#include "blend.h"
+#include "memory.h"
+#include "tinybit.h"
+#include "rng.h"
+
+static const int sin_table[] = {
+    0, 1143, 2287, 3429, 4571, 5711, 6850, 7986, 9120, 10252, 11380,
+    12504, 13625, 14742, 15854, 16961, 18064, 19160, 20251, 21336, 22414,
+    23486, 24550, 25606, 26655, 27696, 28729, 29752, 30767, 31772, 32768,
+    33753, 34728, 35693, 36647, 37589, 38521, 39440, 40347, 41243, 42125,
+    42995, 43852, 44695, 45525, 46340, 47142, 47929, 48702, 49460, 50203,
+    50931, 51643, 52339, 53019, 53683, 54331, 54963, 55577, 56175, 56755,
+    57319, 57864, 58393, 58903, 59395, 59870, 60326, 60763, 61183, 61583,
+    61965, 62328, 62672, 62997, 63302, 63589, 63856, 64103, 64331, 64540,
+    64729, 64898, 65047, 65176, 65286, 65376, 65446, 65496, 65526, 65536,
+};
+
+// Reset all graphics state to defaults (called from tinybit_init)
+void graphics_init(tinybit_ctx* ctx) {
+    ctx->graphics.fillColor = 0;
+    ctx->graphics.strokeColor = 0;
+    ctx->graphics.strokeWidth = 0;
+    ctx->graphics.polygon_point_count = 0;
+    spritesheet_changed(ctx);
+}
+
+#define CELLS_PER_ROW (TB_SCREEN_WIDTH / 8)
+
+static void mark_cell(tinybit_ctx* ctx, int n) {
+    ctx->graphics.dirty_cells[n / 32] |= 1u << (n % 32);
+}
+
+// Call after the whole spritesheet may have been written
+void spritesheet_changed(tinybit_ctx* ctx) {
+    for (int n = 0; n < TB_SPRITE_CELLS; n++) {
+        mark_cell(ctx, n);
+    }
+    ctx->graphics.sheet_dirty = true;
+}
+
+// Call after count spritesheet pixels from index first were written
+void spritesheet_changed_pixels(tinybit_ctx* ctx, int first, int count) {
+    if (count <= 0) return;
+    int last = first + count - 1;
+    int firstY = first / TB_SCREEN_WIDTH, lastY = last / TB_SCREEN_WIDTH;
+    int firstX = firstY == lastY ? first % TB_SCREEN_WIDTH : 0;
+    int lastX = firstY == lastY ? last % TB_SCREEN_WIDTH : TB_SCREEN_WIDTH - 1;
+
+    for (int cy = firstY / 8; cy <= lastY / 8; cy++) {
+        for (int cx = firstX / 8; cx <= lastX / 8; cx++) {
+            mark_cell(ctx, cy * CELLS_PER_ROW + cx);
+        }
+    }
+    ctx->graphics.sheet_dirty = true;
+}
+
+static int classify_span(const uint16_t* span) {
+    uint16_t all = 0xFFFF, any = 0;
+    for (int i = 0; i < 8; i++) {
+        all &= span[i];
+        any |= span[i];
+    }
+    // alpha is the low nibble of the high byte
+    if ((all & 0x0F00) == 0x0F00) return CELL_OPAQUE;
+    if ((any & 0x0F00) == 0) return CELL_TRANSPARENT;
+    return CELL_MIXED;
+}
+
+static void classify_cell(tinybit_ctx* ctx, int n) {
+    int cx = n % CELLS_PER_ROW, cy = n / CELLS_PER_ROW;
+    const uint16_t* span = ctx->memory->spritesheet + cy * 8 * TB_SCREEN_WIDTH + cx * 8;
+    int opaque = 0, transparent = 0;
+
+    for (int row = 0; row < 8; row++) {
+        int class = classify_span(span);
+        ctx->graphics.span_class[cy * 8 + row][cx] = class;
+        opaque += class == CELL_OPAQUE;
+        transparent += class == CELL_TRANSPARENT;
+        span += TB_SCREEN_WIDTH;
+    }
+    ctx->graphics.cell_class[n] = opaque == 8 ? CELL_OPAQUE
+                                : transparent == 8 ? CELL_TRANSPARENT
+                                : CELL_MIXED;
+}
+
+// Bring the classes of changed cells up to date before drawing from them
+static void classify_sheet(tinybit_ctx* ctx) {
+    if (!ctx->graphics.sheet_dirty) return;
+    for (int i = 0; i < TB_SPRITE_CELLS / 32; i++) {
+        uint32_t bits = ctx->graphics.dirty_cells[i];
+        for (int bit = 0; bits; bit++, bits >>= 1) {
+            if (bits & 1) {
+                classify_cell(ctx, i * 32 + bit);
+            }
+        }
+        ctx->graphics.dirty_cells[i] = 0;
+    }
+    ctx->graphics.sheet_dirty = false;
+}
+
+// Fast sine approximation using lookup table
+int fast_sin(int angle) {
+    angle = angle % 360;
+    if (angle < 0) angle += 360;
+
+    if (angle <= 90) return sin_table[angle];
+    else if (angle <= 180) return sin_table[180 - angle];
+    else if (angle <= 270) return -sin_table[angle - 180];
+    else return -sin_table[360 - angle];
+}
+
+// Fast cosine approximation using sine lookup table
+int fast_cos(int angle) {
+    return fast_sin(angle + 90);
+}
+
+// Alpha blend foreground pixel onto destination pixel
+// Pixel format: uint16_t where low byte = RRRRGGGG, high byte = BBBBAAAA
+#ifdef TB_BLEND_LUT
+void blend(uint16_t* dst, uint16_t fg) {
+    *dst = blend_lut_pixel(*dst, fg);
+}
+#else
+void blend(uint16_t* dst, uint16_t fg) {
+    uint8_t fg_r = fg & 0xF0;
+    uint8_t fg_g = (fg & 0x0F) << 4;
+    uint8_t fg_b = (fg >> 8) & 0xF0;
+    uint8_t fg_a = ((fg >> 8) & 0x0F) << 4;
+
+    if (fg_a == 0xF0) {
+        *dst = fg;
+        return;
+    }
+    if (fg_a == 0x00) {
+        return;
+    }
+
+    uint16_t bg = *dst;
+    uint8_t bg_r = bg & 0xF0;
+    uint8_t bg_g = (bg & 0x0F) << 4;
+    uint8_t bg_b = (bg >> 8) & 0xF0;
+    uint8_t bg_a = ((bg >> 8) & 0x0F) << 4;
+
+    uint8_t inverse_alpha = 0xF0 - fg_a;
+
+    uint8_t out_r = (fg_r * fg_a + bg_r * inverse_alpha) >> 8;
+    uint8_t out_g = (fg_g * fg_a + bg_g * inverse_alpha) >> 8;
+    uint8_t out_b = (fg_b * fg_a + bg_b * inverse_alpha) >> 8;
+    uint8_t out_a = fg_a + ((bg_a * inverse_alpha) >> 8);
+
+    *dst = pack_color(out_r, out_g, out_b, out_a);
+}
+#endif
+
+// Generate random integer within specified range
+int random_range(tinybit_ctx* ctx, int min, int max) {
+    return rng_range(ctx->rng, min, max);
+}
+
+// Unscaled spritesheet blit: each source row is walked in runs of 8-pixel
+// spans of one class, copying opaque runs, skipping transparent ones and
+// blending the rest. Clipping is the caller's; source pixels off the sheet draw nothing.
+static void draw_sprite_spans(tinybit_ctx* ctx, int sourceX, int sourceY, int targetX, int targetY,
+                              int clipStartX, int clipStartY, int clipEndX, int clipEndY) {
+    if (sourceX + clipStartX < 0) clipStartX = -sourceX;
+    if (sourceX + clipEndX > TB_SCREEN_WIDTH) clipEndX = TB_SCREEN_WIDTH - sourceX;
+    if (sourceY + clipStartY < 0) clipStartY = -sourceY;
+    if (sourceY + clipEndY > TB_SCREEN_HEIGHT) clipEndY = TB_SCREEN_HEIGHT - sourceY;
+    if (clipStartX >= clipEndX) return;
+
+    classify_sheet(ctx);
+
+    for (int y = clipStartY; y < clipEndY; ++y) {
+        const uint16_t* src = ctx->memory->spritesheet + (sourceY + y) * TB_SCREEN_WIDTH;
+        uint16_t* dst = ctx->memory->display + (targetY + y) * TB_SCREEN_WIDTH;
+        const uint8_t* spans = ctx->graphics.span_class[sourceY + y];
+
+        for (int x = clipStartX; x < clipEndX;) {
+            // a run of spans of the same class
+            int span = (sourceX + x) / 8;
+            int class = spans[span];
+            int end;
+            do {
+                end = ++span * 8 - sourceX;
+            } while (end < clipEndX && spans[span] == class);
+            if (end > clipEndX) end = clipEndX;
+
+            if (class == CELL_OPAQUE) {
+                memcpy(&dst[targetX + x], &src[sourceX + x], (end - x) * sizeof(uint16_t));
+            } else if (class == CELL_MIXED) {
+                blend_span(&dst[targetX + x], &src[sourceX + x], end - x);
+            }
+            x = end;
+        }
+    }
+}
+
+// Draw a sprite from spritesheet to display with scaling and clipping
+void draw_sprite(tinybit_ctx* ctx, int sourceX, int sourceY, int sourceW, int sourceH, int targetX, int targetY, int targetW, int targetH, TARGET target) {
+    uint16_t* src_buf;
+    if (target == TARGET_SPRITESHEET) {
+        src_buf = ctx->memory->spritesheet;
+    } else {
+        src_buf = ctx->memory->display;
+    }
+
+    int clipStartX = targetX < 0 ? -targetX : 0;
+    int clipStartY = targetY < 0 ? -targetY : 0;
+    int clipEndX = (targetX + targetW > TB_SCREEN_WIDTH) ? TB_SCREEN_WIDTH - targetX : targetW;
+    int clipEndY = (targetY + targetH > TB_SCREEN_HEIGHT) ? TB_SCREEN_HEIGHT - targetY : targetH;
+
+    if (clipStartX >= clipEndX || clipStartY >= clipEndY) return;
+    count_pixels(ctx, (uint64_t)(clipEndX - clipStartX) * (clipEndY - clipStartY));
+
+    if (target == TARGET_SPRITESHEET && sourceW == targetW && sourceH == targetH) {
+        draw_sprite_spans(ctx, sourceX, sourceY, targetX, targetY, clipStartX, clipStartY, clipEndX, clipEndY);
+        return;
+    }
+
+    int scale_x_fixed_point = (sourceW << 16) / targetW;
+    int scale_y_fixed_point = (sourceH << 16) / targetH;
+
+    uint16_t* dst = ctx->memory->display + (targetY + clipStartY) * TB_SCREEN_WIDTH + targetX + clipStartX;
+
+    for (int y = clipStartY; y < clipEndY; ++y) {
+        int sourcePixelY = sourceY + ((y * scale_y_fixed_point) >> 16);
+
+        if (sourcePixelY < 0 || sourcePixelY >= TB_SCREEN_HEIGHT) {
+            dst += TB_SCREEN_WIDTH;
+            continue;
+        }
+
+        uint16_t* src_row = src_buf + sourcePixelY * TB_SCREEN_WIDTH;
+
+        for (int x = clipStartX; x < clipEndX; ++x) {
+            int sourcePixelX = sourceX + ((x * scale_x_fixed_point) >> 16);
+            if (sourcePixelX >= 0 && sourcePixelX < TB_SCREEN_WIDTH) {
+                blend(dst, src_row[sourcePixelX]);
+            }
+            dst++;
+        }
+        dst += TB_SCREEN_WIDTH - (clipEndX - clipStartX);
+    }
+}
+
+// Draw the n-th 8x8 spritesheet cell at (x, y), optionally flipped
+void draw_cell(tinybit_ctx* ctx, int n, int x, int y, int flags) {
+    if (n < 0 || n >= TB_SPRITE_CELLS) return;
+
+    int clipStartX = x < 0 ? -x : 0;
+    int clipStartY = y < 0 ? -y : 0;
+    int clipEndX = (x + 8 > TB_SCREEN_WIDTH) ? TB_SCREEN_WIDTH - x : 8;
+    int clipEndY = (y + 8 > TB_SCREEN_HEIGHT) ? TB_SCREEN_HEIGHT - y : 8;
+
+    if (clipStartX >= clipEndX || clipStartY >= clipEndY) return;
+    count_pixels(ctx, (uint64_t)(clipEndX - clipStartX) * (clipEndY - clipStartY));
+
+    classify_sheet(ctx);
+    int class = ctx->graphics.cell_class[n];
+    if (class == CELL_TRANSPARENT) return;
+
+    int cellX = n % CELLS_PER_ROW, cellY = (n / CELLS_PER_ROW) * 8;
+    const uint16_t* cell = ctx->memory->spritesheet + cellY * TB_SCREEN_WIDTH + cellX * 8;
+    // dst points at the first visible column of the row
+    uint16_t* dst = ctx->memory->display + (y + clipStartY) * TB_SCREEN_WIDTH + x + clipStartX;
+    int width = clipEndX - clipStartX;
+
+    for (int row = clipStartY; row < clipEndY; ++row, dst += TB_SCREEN_WIDTH) {
+        int srcRow = (flags & FLIP_Y) ? 7 - row : row;
+        const uint16_t* src = cell + srcRow * TB_SCREEN_WIDTH;
+        int rowClass = class == CELL_MIXED ? ctx->graphics.span_class[cellY + srcRow][cellX] : class;
+
+        if (rowClass == CELL_TRANSPARENT) {
+            continue;
+        } else if (rowClass == CELL_OPAQUE && !(flags & FLIP_X)) {
+            // blending an opaque pixel replaces it
+            memcpy(dst, &src[clipStartX], width * sizeof(uint16_t));
+        } else if (rowClass == CELL_OPAQUE) {
+            for (int col = clipStartX; col < clipEndX; ++col) {
+                dst[col - clipStartX] = src[7 - col];
+            }
+        } else if (flags & FLIP_X) {
+            for (int col = clipStartX; col < clipEndX; ++col) {
+                blend(&dst[col - clipStartX], src[7 - col]);
+            }
+        } else {
+            blend_span(dst, &src[clipStartX], width);
+        }
+    }
+}
+
+// Draw a cellW x cellH block of the tilemap starting at cell (cellX, cellY)
+// with its top-left corner at (targetX, targetY). Cell 0 is empty.
+void draw_map(tinybit_ctx* ctx, int cellX, int cellY, int targetX, int targetY, int cellW, int cellH) {
+    // only the cells that land on screen
+    int startX = targetX < 0 ? -targetX / 8 : 0;
+    int startY = targetY < 0 ? -targetY / 8 : 0;
+    int endX = cellW, endY = cellH;
+    if (targetX + endX * 8 > TB_SCREEN_WIDTH) endX = (TB_SCREEN_WIDTH - targetX + 7) / 8;
+    if (targetY + endY * 8 > TB_SCREEN_HEIGHT) endY = (TB_SCREEN_HEIGHT - targetY + 7) / 8;
+
+    // and only the ones inside the map
+    if (cellX + startX < 0) startX = -cellX;
+    if (cellY + startY < 0) startY = -cellY;
+    if (cellX + endX > TB_MAP_WIDTH) endX = TB_MAP_WIDTH - cellX;
+    if (cellY + endY > TB_MAP_HEIGHT) endY = TB_MAP_HEIGHT - cellY;
+
+    for (int j = startY; j < endY; j++) {
+        const uint8_t* cells = ctx->memory->tilemap + (cellY + j) * TB_MAP_WIDTH + cellX;
+        for (int i = startX; i < endX; i++) {
+            if (cells[i] != 0) {
+                draw_cell(ctx, cells[i], targetX + i * 8, targetY + j * 8, 0);
+            }
+        }
+    }
+}
+
+// Draw a rotated sprite from spritesheet to display with scaling and clipping
+void draw_sprite_rotated(tinybit_ctx* ctx, int sourceX, int sourceY, int sourceW, int sourceH, int targetX, int targetY, int targetW, int targetH, int angleDegrees, TARGET target) {
+    uint16_t* src_buf;
+    if (target == TARGET_SPRITESHEET) {
+        src_buf = ctx->memory->spritesheet;
+    } else {
+        src_buf = ctx->memory->display;
+    }
+
+    int cosA = fast_cos(angleDegrees);
+    int sinA = fast_sin(angleDegrees);
+
+    int centerX = targetW >> 1;
+    int centerY = targetH >> 1;
+
+    // Calculate expanded bounds for rotated sprite to prevent clipping
+    int absCosSin = (abs(cosA) + abs(sinA)) >> 16;
+    if (absCosSin == 0) absCosSin = 1;
+
+    int expandedW = (targetW * absCosSin) + targetW;
+    int expandedH = (targetH * absCosSin) + targetH;
+
+    int expandX = (expandedW - targetW) >> 1;
+    int expandY = (expandedH - targetH) >> 1;
+
+    int clipStartX = (targetX - expandX) < 0 ? -(targetX - expandX) : 0;
+    int clipStartY = (targetY - expandY) < 0 ? -(targetY - expandY) : 0;
+    int clipEndX = (targetX - expandX + expandedW > TB_SCREEN_WIDTH) ? TB_SCREEN_WIDTH - (targetX - expandX) : expandedW;
+    int clipEndY = (targetY - expandY + expandedH > TB_SCREEN_HEIGHT) ? TB_SCREEN_HEIGHT - (targetY - expandY) : expandedH;
+
+    if (clipStartX >= clipEndX || clipStartY >= clipEndY) return;
+    count_pixels(ctx, (uint64_t)(clipEndX - clipStartX) * (clipEndY - clipStartY));
+
+    int scale_x_fixed_point = (sourceW << 16) / targetW;
+    int scale_y_fixed_point = (sourceH << 16) / targetH;
+
+    uint16_t* display = ctx->memory->display;
+
+    for (int y = clipStartY; y < clipEndY; ++y) {
+        for (int x = clipStartX; x < clipEndX; ++x) {
+            int screenX = targetX - expandX + x;
+            int screenY = targetY - expandY + y;
+
+            if (screenX < 0 || screenX >= TB_SCREEN_WIDTH || screenY < 0 || screenY >= TB_SCREEN_HEIGHT) continue;
+
+            int relX = x - expandX - centerX;
+            int relY = y - expandY - centerY;
+
+            int rotX = ((relX * cosA + relY * sinA) >> 16) + centerX;
+            int rotY = ((-relX * sinA + relY * cosA) >> 16) + centerY;
+
+            if (rotX >= 0 && rotX < targetW && rotY >= 0 && rotY < targetH) {
+                int sourcePixelX = sourceX + ((rotX * scale_x_fixed_point) >> 16);
+                int sourcePixelY = sourceY + ((rotY * scale_y_fixed_point) >> 16);
+
+                if (sourcePixelX >= 0 && sourcePixelX < TB_SCREEN_WIDTH &&
+                    sourcePixelY >= 0 && sourcePixelY < TB_SCREEN_HEIGHT) {
+
+                    blend(&display[screenY * TB_SCREEN_WIDTH + screenX],
+                          src_buf[sourcePixelY * TB_SCREEN_WIDTH + sourcePixelX]);
+                }
+            }
+        }
+    }
+}
+
+// Draw a rectangle with optional stroke and fill
+void draw_rect(tinybit_ctx* ctx, int x, int y, int w, int h) {
+    int clipX = x < 0 ? 0 : x;
+    int clipY = y < 0 ? 0 : y;
+    int clipW = ((x + w > TB_SCREEN_WIDTH) ? TB_SCREEN_WIDTH : x + w) - clipX;
+    int clipH = ((y + h > TB_SCREEN_HEIGHT) ? TB_SCREEN_HEIGHT : y + h) - clipY;
+
+    if (clipX >= TB_SCREEN_WIDTH || clipY >= TB_SCREEN_HEIGHT || clipW <= 0 || clipH <= 0) return;
+
+    uint16_t* origin = ctx->memory->display + clipY * TB_SCREEN_WIDTH + clipX;
+    int strokeWidth = ctx->graphics.strokeWidth;
+    uint16_t strokeColor = ctx->graphics.strokeColor;
+
+    if (strokeWidth > 0) {
+        // top and bottom bands
+        for (int i = 0; i < strokeWidth && i < clipH; i++) {
+            blend_fill(origin + i * TB_SCREEN_WIDTH, strokeColor, clipW);
+            if (clipH - 1 - i != i) {
+                blend_fill(origin + (clipH - 1 - i) * TB_SCREEN_WIDTH, strokeColor, clipW);
+            }
+        }
+
+        // left and right edges; when they overlap, the pixels they share are
+        // blended twice, except for the middle column of an odd width
+        int edge = strokeWidth < clipW ? strokeWidth : clipW;
+        int middle = (clipW & 1) && (clipW - 1) / 2 < edge ? (clipW - 1) / 2 : -1;
+        for (int j = strokeWidth; j < clipH - strokeWidth; j++) {
+            uint16_t* row = origin + j * TB_SCREEN_WIDTH;
+            blend_fill(row, strokeColor, edge);
+            if (middle < 0) {
+                blend_fill(row + clipW - edge, strokeColor, edge);
+            } else {
+                blend_fill(row + clipW - edge, strokeColor, middle - (clipW - edge));
+                blend_fill(row + middle + 1, strokeColor, clipW - middle - 1);
+            }
+        }
+    }
+
+    int fillW = clipW - 2 * strokeWidth;
+    int fillH = clipH - 2 * strokeWidth;
+
+    if (strokeWidth > 0) {
+        count_pixels(ctx, (uint64_t)clipW * clipH);
+    } else if (fillW > 0 && fillH > 0) {
+        count_pixels(ctx, (uint64_t)fillW * fillH);
+    }
+
+    if (fillW > 0 && fillH > 0) {
+        uint16_t* row = origin + strokeWidth * TB_SCREEN_WIDTH + strokeWidth;
+        for (int j = 0; j < fillH; j++, row += TB_SCREEN_WIDTH) {
+            blend_fill(row, ctx->graphics.fillColor, fillW);
+        }
+    }
+}
+
+// Largest d >= 0 with d * d * scale <= limit; -1 if there is none, and
+// "unbounded" (INT_MAX / 2) when scale is 0 and limit is not negative
+static int half_span(int64_t limit, int64_t scale) {
+    if (limit < 0) return -1;
+    if (scale == 0) return INT_MAX / 2;
+
+    // integer square root of limit / scale
+    int64_t n = limit / scale, root = 0, bit = (int64_t)1 << 62;
+    while (bit > n) bit >>= 2;
+    while (bit) {
+        if (n >= root + bit) {
+            n -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root > INT_MAX / 2 ? INT_MAX / 2 : (int)root;
+}
+
+// Blend color over columns [from, to] of a shape whose left edge is at
+// screen column x, clipped to [clipFrom, clipTo); row is the screen row
+static void fill_columns(uint16_t* row, int x, int from, int to, int clipFrom, int clipTo, uint16_t color) {
+    if (from < clipFrom) from = clipFrom;
+    if (to >= clipTo) to = clipTo - 1;
+    if (from <= to) {
+        blend_fill(row + x + from, color, to - from + 1);
+    }
+}
+
+// Draw an oval with optional stroke and fill
+void draw_oval(tinybit_ctx* ctx, int x, int y, int w, int h) {
+    int rx = w >> 1;
+    int ry = h >> 1;
+    int64_t rx2 = (int64_t)rx * rx;
+    int64_t ry2 = (int64_t)ry * ry;
+
+    int strokeRx = rx - ctx->graphics.strokeWidth;
+    int strokeRy = ry - ctx->graphics.strokeWidth;
+    int64_t strokeRx2 = (int64_t)strokeRx * strokeRx;
+    int64_t strokeRy2 = (int64_t)strokeRy * strokeRy;
+    bool stroked = ctx->graphics.strokeWidth > 0 && strokeRx > 0 && strokeRy > 0;
+
+    // columns i of the bounding box that are on screen
+    int clipFrom = x < 0 ? -x : 0;
+    int clipTo = x + w > TB_SCREEN_WIDTH ? TB_SCREEN_WIDTH - x : w;
+    uint32_t touched = 0;
+
+    int rowFrom = y < 0 ? -y : 0;
+    int rowTo = y + h > TB_SCREEN_HEIGHT ? TB_SCREEN_HEIGHT - y : h;
+
+    for (int j = rowFrom; j < rowTo; j++) {
+        int py = y + j;
+
+        // each row of the oval is one span around the center column rx:
+        // |i - rx| <= outer is inside, |i - rx| <= inner is fill
+        int64_t dy2 = (int64_t)(j - ry) * (j - ry);
+        int outer = half_span(rx2 * ry2 - dy2 * rx2, ry2);
+        if (outer < 0) continue;
+        int inner = stroked ? half_span(strokeRx2 * strokeRy2 - dy2 * strokeRx2, strokeRy2) : outer;
+
+        int from = rx - outer < clipFrom ? clipFrom : rx - outer;
+        int to = rx + outer >= clipTo ? clipTo - 1 : rx + outer;
+        if (from > to) continue;
+        touched += to - from + 1;
+
+        uint16_t* row = ctx->memory->display + py * TB_SCREEN_WIDTH;
+        if (inner < 0) {
+            fill_columns(row, x, from, to, from, to + 1, ctx->graphics.strokeColor);
+        } else if (inner < outer) {
+            fill_columns(row, x, from, rx - inner - 1, from, to + 1, ctx->graphics.strokeColor);
+            fill_columns(row, x, rx - inner, rx + inner, from, to + 1, ctx->graphics.fillColor);
+            fill_columns(row, x, rx + inner + 1, to, from, to + 1, ctx->graphics.strokeColor);
+        } else {
+            fill_columns(row, x, from, to, from, to + 1, ctx->graphics.fillColor);
+        }
+    }
+    count_pixels(ctx, touched);
+}
+
+// Set stroke color and width for drawing operations
+void set_stroke(tinybit_ctx* ctx, int width, uint16_t color) {
+    ctx->graphics.strokeWidth = width >= 0 ? width : 0;
+    ctx->graphics.strokeColor = color;
+}
+
+// Set fill color for drawing operations
+void set_fill(tinybit_ctx* ctx, uint16_t color) {
+    ctx->graphics.fillColor = color;
+}
+
+// Draw a single pixel at specified coordinates
+void draw_pixel(tinybit_ctx* ctx, int x, int y) {
+    if (x < 0 || x >= TB_SCREEN_WIDTH || y < 0 || y >= TB_SCREEN_HEIGHT) {
+        return;
+    }
+    uint16_t* display = ctx->memory->display;
+    blend(&display[y * TB_SCREEN_WIDTH + x], ctx->graphics.fillColor);
+    count_pixels(ctx, 1);
+}
+
+// Set a pixel at specified coordinates to a specific color
+void pset(tinybit_ctx* ctx, int x, int y, uint16_t color) {
+    if (x < 0 || x >= TB_SCREEN_WIDTH || y < 0 || y >= TB_SCREEN_HEIGHT) {
+        return;
+    }
+    uint16_t* display = ctx->memory->display;
+    display[y * TB_SCREEN_WIDTH + x] = color;
+    count_pixels(ctx, 1);
+}
+
+// Get the color of a pixel at specified coordinates
+uint16_t pget(tinybit_ctx* ctx, int x, int y) {
+    if (x < 0 || x >= TB_SCREEN_WIDTH || y < 0 || y >= TB_SCREEN_HEIGHT) {
+        return 0;
+    }
+    uint16_t* display = ctx->memory->display;
+    return display[y * TB_SCREEN_WIDTH + x];
+}
+
+// Draw a line between two points using Bresenham's algorithm
+void draw_line(tinybit_ctx* ctx, int x1, int y1, int x2, int y2) {
+    if (ctx->graphics.strokeWidth <= 0) return;
+
+    uint16_t* display = ctx->memory->display;
+    uint32_t touched = 0;
+
+    int dx = abs(x2 - x1);
+    int dy = abs(y2 - y1);
+    int sx = x1 < x2 ? 1 : -1;
+    int sy = y1 < y2 ? 1 : -1;
+    int err = dx - dy;
+
+    int x = x1;
+    int y = y1;
+
+    while (1) {
+        if (ctx->graphics.strokeWidth == 1) {
+            if (x >= 0 && x < TB_SCREEN_WIDTH && y >= 0 && y < TB_SCREEN_HEIGHT) {
+                blend(&display[y * TB_SCREEN_WIDTH + x], ctx->graphics.strokeColor);
+                touched++;
+            }
+        } else {
+            // square brush, one span per row
+            int radius = ctx->graphics.strokeWidth >> 1;
+            int left = x - radius < 0 ? 0 : x - radius;
+            int right = x + radius >= TB_SCREEN_WIDTH ? TB_SCREEN_WIDTH - 1 : x + radius;
+            for (int py = y - radius; py <= y + radius && left <= right; py++) {
+                if (py >= 0 && py < TB_SCREEN_HEIGHT) {
+                    blend_fill(&display[py * TB_SCREEN_WIDTH + left], ctx->graphics.strokeColor, right - left + 1);
+                    touched += right - left + 1;
+                }
+            }
+        }
+
+        if (x == x2 && y == y2) break;
+
+        int e2 = 2 * err;
+        if (e2 > -dy) {
+            err -= dy;
+            x += sx;
+        }
+        if (e2 < dx) {
+            err += dx;
+            y += sy;
+        }
+    }
+    count_pixels(ctx, touched);
+}
+
+// Clear the display buffer (set all pixels to black/transparent)
+void draw_cls(tinybit_ctx* ctx) {
+    memset(ctx->memory->display, 0, sizeof(ctx->memory->display));
+    count_pixels(ctx, TB_SCREEN_WIDTH * TB_SCREEN_HEIGHT);
+}
+
+// Add a point to the polygon vertex list
+void poly_add(tinybit_ctx* ctx, int x, int y) {
+    if (ctx->graphics.polygon_point_count < TB_MAX_POLYGON_POINTS) {
+        ctx->graphics.polygon_points[ctx->graphics.polygon_point_count].x = x;
+        ctx->graphics.polygon_points[ctx->graphics.polygon_point_count].y = y;
+        ctx->graphics.polygon_point_count++;
+    }
+}
+
+// Clear the polygon vertex list
+void poly_clear(tinybit_ctx* ctx) {
+    ctx->graphics.polygon_point_count = 0;
+}
+
+// Draw a filled polygon using the current vertex list with optional stroke
+void draw_polygon(tinybit_ctx* ctx) {
+    if (ctx->graphics.polygon_point_count < 3) return;
+
+    uint16_t* display = ctx->memory->display;
+
+    int minY = ctx->graphics.polygon_points[0].y;
+    int maxY = ctx->graphics.polygon_points[0].y;
+
+    for (int i = 1; i < ctx->graphics.polygon_point_count; i++) {
+        if (ctx->graphics.polygon_points[i].y < minY) minY = ctx->graphics.polygon_points[i].y;
+        if (ctx->graphics.polygon_points[i].y > maxY) maxY = ctx->graphics.polygon_points[i].y;
+    }
+
+    if (minY >= TB_SCREEN_HEIGHT || maxY < 0) return;
+
+    minY = minY < 0 ? 0 : minY;
+    maxY = maxY >= TB_SCREEN_HEIGHT ? TB_SCREEN_HEIGHT - 1 : maxY;
+
+    for (int y = minY; y <= maxY; y++) {
+        int intersections[TB_MAX_POLYGON_POINTS];
+        int intersectionCount = 0;
+
+        for (int i = 0; i < ctx->graphics.polygon_point_count; i++) {
+            int j = (i + 1) % ctx->graphics.polygon_point_count;
+            int y1 = ctx->graphics.polygon_points[i].y;
+            int y2 = ctx->graphics.polygon_points[j].y;
+
+            if ((y1 <= y && y2 > y) || (y2 <= y && y1 > y)) {
+                int x1 = ctx->graphics.polygon_points[i].x;
+                int x2 = ctx->graphics.polygon_points[j].x;
+                int x = x1 + ((y - y1) * (x2 - x1)) / (y2 - y1);
+                intersections[intersectionCount++] = x;
+            }
+        }
+
+        for (int i = 0; i < intersectionCount - 1; i++) {
+            for (int j = i + 1; j < intersectionCount; j++) {
+                if (intersections[i] > intersections[j]) {
+                    int temp = intersections[i];
+                    intersections[i] = intersections[j];
+                    intersections[j] = temp;
+                }
+            }
+        }
+
+        for (int i = 0; i < intersectionCount; i += 2) {
+            if (i + 1 < intersectionCount) {
+                int x1 = intersections[i];
+                int x2 = intersections[i + 1];
+
+                x1 = x1 < 0 ? 0 : x1;
+                x2 = x2 >= TB_SCREEN_WIDTH ? TB_SCREEN_WIDTH - 1 : x2;
+                if (x2 >= x1) {
+                    count_pixels(ctx, (uint64_t)(x2 - x1 + 1));
+                    blend_fill(&display[y * TB_SCREEN_WIDTH + x1], ctx->graphics.fillColor, x2 - x1 + 1);
+                }
+            }
+        }
+    }
+
+    if (ctx->graphics.strokeWidth > 0) {
+        for (int i = 0; i < ctx->graphics.polygon_point_count; i++) {
+            int j = (i + 1) % ctx->graphics.polygon_point_count;
+            draw_line(ctx, ctx->graphics.polygon_points[i].x, ctx->graphics.polygon_points[i].y,
+                     ctx->graphics.polygon_points[j].x, ctx->graphics.polygon_points[j].y);
+        }
+    }
+}
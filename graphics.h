@@ -1,48 +1,67 @@
-#ifndef GRAPHICS_H
-#define GRAPHICS_H
-
-#include <stdint.h>
-
-struct Color{
-    uint8_t r, g, b, a;
-};
-
-typedef enum {
-	TARGET_MEMORY,
-    TARGET_DISPLAY,
-    TARGET_SPRITESHEET
-} TARGET;
-
-// Pixel format: uint16_t where low byte = RRRRGGGG, high byte = BBBBAAAA
-extern uint16_t fillColor;
-extern uint16_t strokeColor;
-
-extern int strokeWidth;
-
-// Pack RGBA components (8-bit each, upper 4 bits used) into a RGBA4444 pixel
-static inline uint16_t pack_color(int r, int g, int b, int a) {
-    uint8_t rg = (r & 0xF0) | ((g >> 4) & 0x0F);
-    uint8_t ba = (b & 0xF0) | ((a >> 4) & 0x0F);
-    return (uint16_t)rg | ((uint16_t)ba << 8);
-}
-
-// Graphics function declarations
-void graphics_init();
-int random_range(int, int);
-void draw_sprite(int sourceX, int sourceY, int sourceW, int sourceH, int targetX, int targetY, int targetW, int targetH, TARGET target);
-void draw_sprite_rotated(int sourceX, int sourceY, int sourceW, int sourceH, int targetX, int targetY, int targetW, int targetH, int angleDegrees, TARGET target);
-void draw_rect(int x, int y, int w, int h);
-void draw_oval(int x, int y, int w, int h);
-void set_stroke(int width, uint16_t color);
-void set_fill(uint16_t color);
-void draw_pixel(int x, int y);
-void pset(int x, int y, uint16_t color);
-uint16_t pget(int x, int y);
-void draw_line(int x1, int y1, int x2, int y2);
-void draw_cls();
-void poly_add(int x, int y);
-void poly_clear();
-void draw_polygon();
-void blend(uint16_t* dst, uint16_t fg);
-
-#endif
+#ifndef GRAPHICS_H
+#define GRAPHICS_H
+
+#include <stdint.h>
+
+#include "tinybit.h"
+
+struct Color{
+    uint8_t r, g, b, a;
+};
+
+typedef enum {
+	TARGET_MEMORY,
+    TARGET_DISPLAY,
+    TARGET_SPRITESHEET
+} TARGET;
+
+// Cell flags for draw_cell
+#define FLIP_X 1
+#define FLIP_Y 2
+
+// Alpha class of a spritesheet cell or row span
+enum {
+    CELL_MIXED,
+    CELL_OPAQUE,      // every pixel has full alpha
+    CELL_TRANSPARENT  // every pixel has zero alpha
+};
+
+// Pack RGBA components (8-bit each, upper 4 bits used) into a RGBA4444 pixel
+static inline uint16_t pack_color(int r, int g, int b, int a) {
+    uint8_t rg = (r & 0xF0) | ((g >> 4) & 0x0F);
+    uint8_t ba = (b & 0xF0) | ((a >> 4) & 0x0F);
+    return (uint16_t)rg | ((uint16_t)ba << 8);
+}
+
+// Credit drawn pixels to the Lua binding being measured; a no-op unless API
+// stats are enabled
+static inline void count_pixels(tinybit_ctx* ctx, uint64_t n) {
+    if (ctx->api.enabled) {
+        ctx->api.pixels += n;
+    }
+}
+
+// Graphics function declarations
+void graphics_init(tinybit_ctx* ctx);
+int random_range(tinybit_ctx* ctx, int, int);
+void draw_sprite(tinybit_ctx* ctx, int sourceX, int sourceY, int sourceW, int sourceH, int targetX, int targetY, int targetW, int targetH, TARGET target);
+void spritesheet_changed(tinybit_ctx* ctx);
+void spritesheet_changed_pixels(tinybit_ctx* ctx, int first, int count);
+void draw_cell(tinybit_ctx* ctx, int n, int x, int y, int flags);
+void draw_map(tinybit_ctx* ctx, int cellX, int cellY, int targetX, int targetY, int cellW, int cellH);
+void draw_sprite_rotated(tinybit_ctx* ctx, int sourceX, int sourceY, int sourceW, int sourceH, int targetX, int targetY, int targetW, int targetH, int angleDegrees, TARGET target);
+void draw_rect(tinybit_ctx* ctx, int x, int y, int w, int h);
+void draw_oval(tinybit_ctx* ctx, int x, int y, int w, int h);
+void set_stroke(tinybit_ctx* ctx, int width, uint16_t color);
+void set_fill(tinybit_ctx* ctx, uint16_t color);
+void draw_pixel(tinybit_ctx* ctx, int x, int y);
+void pset(tinybit_ctx* ctx, int x, int y, uint16_t color);
+uint16_t pget(tinybit_ctx* ctx, int x, int y);
+void draw_line(tinybit_ctx* ctx, int x1, int y1, int x2, int y2);
+void draw_cls(tinybit_ctx* ctx);
+void poly_add(tinybit_ctx* ctx, int x, int y);
+void poly_clear(tinybit_ctx* ctx);
+void draw_polygon(tinybit_ctx* ctx);
+void blend(uint16_t* dst, uint16_t fg);
+
+#endif
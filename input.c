@@ -1,30 +1,156 @@
-
-#include <stdbool.h>
-#include <stdint.h>
-#include <string.h>
-
-#include "input.h"
-#include "tinybit.h"
-#include "memory.h"
-
-bool prev_button_state[TB_BUTTON_COUNT] = {0};
-
-// Check if a button is currently being pressed
-bool button_down(enum TinyBitButton b){
-	return tinybit_memory->button_input[b];
-}
-
-// Save the current button state for next frame comparison
-void save_button_state(){
-	memcpy(prev_button_state, tinybit_memory->button_input, sizeof(prev_button_state));
-}
-
-// Check if a button is currently being held down
-bool input_btn(enum TinyBitButton b) {
-	return button_down(b);
-}
-
-// Check if a button was just pressed this frame (not held from previous frame)
-bool input_btnp(enum TinyBitButton b) {
-	return button_down(b) && !prev_button_state[b];
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "input.h"
+#include "tinybit.h"
+#include "memory.h"
+
+// Check if a button is currently being pressed
+bool button_down(tinybit_ctx* ctx, enum TinyBitButton b){
+	return ctx->memory->button_input[b];
+}
+
+// Save the current button state for next frame comparison
+void save_button_state(tinybit_ctx* ctx){
+	memcpy(ctx->prev_button_state, ctx->memory->button_input, sizeof(ctx->prev_button_state));
+}
+
+// Start an _update step: btnp() reports the changes since the previous
+// _update, however many frames ago that was, and _draw sees the same ones
+void save_update_button_state(tinybit_ctx* ctx){
+	memcpy(ctx->prev_button_state, ctx->update_button_state, sizeof(ctx->prev_button_state));
+	memcpy(ctx->update_button_state, ctx->memory->button_input, sizeof(ctx->update_button_state));
+}
+
+// Check if a button is currently being held down
+bool input_btn(tinybit_ctx* ctx, enum TinyBitButton b) {
+	return button_down(ctx, b);
+}
+
+// Check if a button was just pressed this frame (not held from previous frame)
+bool input_btnp(tinybit_ctx* ctx, enum TinyBitButton b) {
+	return button_down(ctx, b) && !ctx->prev_button_state[b];
+}
+
+// Recorded input format: a version byte, then runs of (button mask, frame
+// count as LEB128 varint). Bit b of the mask is button b.
+#define INPUT_STREAM_VERSION 1
+
+static uint8_t button_mask(tinybit_ctx* ctx) {
+	uint8_t mask = 0;
+	for (int b = 0; b < TB_BUTTON_COUNT; b++) {
+		if (ctx->memory->button_input[b]) {
+			mask |= 1 << b;
+		}
+	}
+	return mask;
+}
+
+// Append the pending run to the record buffer; stops recording when full
+static void flush_run(tinybit_ctx* ctx) {
+	uint8_t encoded[6];
+	size_t n = 0;
+	uint32_t run = ctx->record.run;
+
+	if (run == 0) return;
+
+	encoded[n++] = ctx->record.mask;
+	do {
+		encoded[n++] = (run & 0x7F) | (run > 0x7F ? 0x80 : 0);
+		run >>= 7;
+	} while (run);
+
+	if (ctx->record.length + n > ctx->record.capacity) {
+		ctx->record.active = false; // keep the runs that fit
+		return;
+	}
+	memcpy(ctx->record.buffer + ctx->record.length, encoded, n);
+	ctx->record.length += n;
+	ctx->record.run = 0;
+}
+
+// Start capturing button_input once per frame into buffer
+bool input_record_start(tinybit_ctx* ctx, uint8_t* buffer, size_t capacity) {
+	if (!buffer || capacity < 1) return false;
+
+	buffer[0] = INPUT_STREAM_VERSION;
+	ctx->record.buffer = buffer;
+	ctx->record.capacity = capacity;
+	ctx->record.length = 1;
+	ctx->record.run = 0;
+	ctx->record.active = true;
+	return true;
+}
+
+// Finish recording; returns the stream length in bytes
+size_t input_record_stop(tinybit_ctx* ctx) {
+	if (ctx->record.active) {
+		flush_run(ctx);
+		ctx->record.active = false;
+	}
+	return ctx->record.length;
+}
+
+// Decode the next run; false at the end of the stream
+static bool next_run(tinybit_ctx* ctx) {
+	const uint8_t* p = ctx->replay.stream;
+	size_t pos = ctx->replay.pos;
+	uint32_t run = 0;
+	int shift = 0;
+
+	if (pos + 2 > ctx->replay.size) return false;
+
+	uint8_t mask = p[pos++];
+	while (pos < ctx->replay.size && shift < 32) {
+		uint8_t byte = p[pos++];
+		run |= (uint32_t)(byte & 0x7F) << shift;
+		shift += 7;
+		if (!(byte & 0x80)) {
+			ctx->replay.mask = mask;
+			ctx->replay.run = run;
+			ctx->replay.pos = pos;
+			return run > 0 || next_run(ctx);
+		}
+	}
+	return false; // truncated varint
+}
+
+// Feed button_input from a recorded stream instead of the input callback
+bool input_replay_start(tinybit_ctx* ctx, const uint8_t* stream, size_t size) {
+	if (!stream || size < 1 || stream[0] != INPUT_STREAM_VERSION) return false;
+
+	ctx->replay.stream = stream;
+	ctx->replay.size = size;
+	ctx->replay.pos = 1;
+	ctx->replay.run = 0;
+	ctx->replay.active = next_run(ctx);
+	return true;
+}
+
+// Fill button_input for this frame: from the replay stream while one is
+// active, otherwise from the host callback; then record it if recording
+void input_poll(tinybit_ctx* ctx) {
+	if (ctx->replay.active) {
+		for (int b = 0; b < TB_BUTTON_COUNT; b++) {
+			ctx->memory->button_input[b] = (ctx->replay.mask >> b) & 1;
+		}
+		if (--ctx->replay.run == 0 && !next_run(ctx)) {
+			ctx->replay.active = false; // stream exhausted, hand back to the host
+		}
+	} else if (ctx->input_func) {
+		ctx->input_func(ctx);
+	}
+
+	if (ctx->record.active) {
+		uint8_t mask = button_mask(ctx);
+		if (ctx->record.run > 0 && (mask != ctx->record.mask || ctx->record.run == UINT32_MAX)) {
+			flush_run(ctx);
+		}
+		if (ctx->record.active) {
+			ctx->record.mask = mask;
+			ctx->record.run++;
+		}
+	}
 }
\ No newline at end of file
@@ -1,14 +1,22 @@
-#ifndef INPUT_H
-#define INPUT_H
-
-#include <stdbool.h>
-
-#include <stdint.h>
-#include "tinybit.h"
-
-// Input function declarations
-void save_button_state();
-bool input_btn(enum TinyBitButton btn);
-bool input_btnp(enum TinyBitButton btn);
-
-#endif
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tinybit.h"
+
+// Input function declarations
+void save_button_state(tinybit_ctx* ctx);
+void save_update_button_state(tinybit_ctx* ctx);
+bool input_btn(tinybit_ctx* ctx, enum TinyBitButton btn);
+bool input_btnp(tinybit_ctx* ctx, enum TinyBitButton btn);
+
+// Input recording and replay
+void input_poll(tinybit_ctx* ctx);
+bool input_record_start(tinybit_ctx* ctx, uint8_t* buffer, size_t capacity);
+size_t input_record_stop(tinybit_ctx* ctx);
+bool input_replay_start(tinybit_ctx* ctx, const uint8_t* stream, size_t size);
+
+#endif
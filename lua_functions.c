@@ -1,588 +1,746 @@
-
-#include "lua/lua.h"
-#include "lua/lualib.h"
-#include "lua/lauxlib.h"
-
-#include <string.h>
-
-#include "lua_functions.h"
-#include "graphics.h"
-#include "memory.h"
-#include "font.h"
-#include "input.h"
-#include "audio.h"
-#include "tinybit.h"
-
-char log_buffer[256];
-void (*log_func)(const char*);
-long frame_time = 0;
-
-// Initialize Lua state with TinyBit libraries and global variables
-void lua_setup(lua_State* L) {
-    
-    // load lua libraries
-    static const luaL_Reg loadedlibs[] = {
-        {LUA_GNAME, luaopen_base},
-        {LUA_COLIBNAME, luaopen_coroutine},
-        {LUA_TABLIBNAME, luaopen_table},
-        {LUA_STRLIBNAME, luaopen_string},
-        {LUA_MATHLIBNAME, luaopen_math},
-        {NULL, NULL}
-    };
-
-    const luaL_Reg* lib;
-    for (lib = loadedlibs; lib->func; lib++) {
-        luaL_requiref(L, lib->name, lib->func, 1);
-        lua_pop(L, 1);  /* remove lib */
-    }
-
-    // set lua waveforms
-    lua_pushinteger(L, SINE);
-    lua_setglobal(L, "SINE");
-    lua_pushinteger(L, SAW);
-    lua_setglobal(L, "SAW");
-    lua_pushinteger(L, SQUARE);
-    lua_setglobal(L, "SQUARE");
-    lua_pushinteger(L, NOISE);
-    lua_setglobal(L, "NOISE");
-
-    lua_pushinteger(L, TB_SCREEN_WIDTH);
-    lua_setglobal(L, "TB_SCREEN_WIDTH");
-    lua_pushinteger(L, TB_SCREEN_HEIGHT);
-    lua_setglobal(L, "TB_SCREEN_HEIGHT");
-
-    lua_pushinteger(L, TB_BUTTON_A);
-	lua_setglobal(L, "A");
-	lua_pushinteger(L, TB_BUTTON_B);
-	lua_setglobal(L, "B");
-	lua_pushinteger(L, TB_BUTTON_UP);
-	lua_setglobal(L, "UP");
-	lua_pushinteger(L, TB_BUTTON_DOWN);
-	lua_setglobal(L, "DOWN");
-	lua_pushinteger(L, TB_BUTTON_LEFT);
-	lua_setglobal(L, "LEFT");
-	lua_pushinteger(L, TB_BUTTON_RIGHT);
-	lua_setglobal(L, "RIGHT");
-	lua_pushinteger(L, TB_BUTTON_START);
-	lua_setglobal(L, "START");
-    lua_pushinteger(L, TB_BUTTON_SELECT);
-	lua_setglobal(L, "SELECT");
-
-    lua_pushcfunction(L, lua_sprite);
-    lua_setglobal(L, "sprite");
-    lua_pushcfunction(L, lua_copy_disp);
-    lua_setglobal(L, "duplicate");
-    lua_pushcfunction(L, lua_line);
-    lua_setglobal(L, "line");
-    lua_pushcfunction(L, lua_millis);
-    lua_setglobal(L, "millis");
-    lua_pushcfunction(L, lua_stroke);
-    lua_setglobal(L, "stroke");
-    lua_pushcfunction(L, lua_fill);
-    lua_setglobal(L, "fill");
-    lua_pushcfunction(L, lua_rect);
-    lua_setglobal(L, "rect");
-    lua_pushcfunction(L, lua_oval);
-    lua_setglobal(L, "oval");
-    lua_pushcfunction(L, lua_btn);
-    lua_setglobal(L, "btn");
-    lua_pushcfunction(L, lua_btnp);
-    lua_setglobal(L, "btnp");
-    lua_pushcfunction(L, lua_mycopy);
-    lua_setglobal(L, "copy");
-    lua_pushcfunction(L, lua_cls);
-    lua_setglobal(L, "cls");
-    lua_pushcfunction(L, lua_peek);
-    lua_setglobal(L, "peek");
-    lua_pushcfunction(L, lua_poke);
-    lua_setglobal(L, "poke");
-    lua_pushcfunction(L, lua_random);
-    lua_setglobal(L, "random");
-    lua_pushcfunction(L, lua_cursor);
-    lua_setglobal(L, "cursor");
-    lua_pushcfunction(L, lua_print);
-    lua_setglobal(L, "print");
-    lua_pushcfunction(L, lua_text);
-    lua_setglobal(L, "text");
-    lua_pushcfunction(L, lua_log);
-    lua_setglobal(L, "log");
-    lua_pushcfunction(L, lua_poly_add);
-    lua_setglobal(L, "poly_add");
-    lua_pushcfunction(L, lua_poly_clear);
-    lua_setglobal(L, "poly_clear");
-    lua_pushcfunction(L, lua_poly);
-    lua_setglobal(L, "draw_polygon");
-    lua_pushcfunction(L, lua_music);
-    lua_setglobal(L, "music");
-    lua_pushcfunction(L, lua_sfx);
-    lua_setglobal(L, "sfx");
-    lua_pushcfunction(L, lua_sfx_active);
-    lua_setglobal(L, "sfx_active");
-    lua_pushcfunction(L, lua_pset);
-    lua_setglobal(L, "pset");
-    lua_pushcfunction(L, lua_pget);
-    lua_setglobal(L, "pget");
-    lua_pushcfunction(L, lua_rgba);
-    lua_setglobal(L, "rgba");
-    lua_pushcfunction(L, lua_rgb);
-    lua_setglobal(L, "rgb");
-    lua_pushcfunction(L, lua_hsb);
-    lua_setglobal(L, "hsb");
-    lua_pushcfunction(L, lua_hsba);
-    lua_setglobal(L, "hsba");
-    lua_pushcfunction(L, lua_sleep);
-    lua_setglobal(L, "sleep");
-}
-
-// Lua function to log messages to the console
-int lua_log(lua_State* L) {
-
-    if (log_func == NULL) {
-        return 0; // No log function set
-    }
-
-    int log_buffer_index = 0;
-    int nargs = lua_gettop(L);
-
-    for (int i = 1; i <= nargs; i++) {
-        if (lua_isstring(L, i)) {
-            const char* str = lua_tostring(L, i);
-            size_t str_len = strlen(str);
-            size_t written = 0;
-            while (written < str_len) {
-                size_t space_left = sizeof(log_buffer) - log_buffer_index - 2; // reserve for space and null
-                size_t chunk = (str_len - written > space_left) ? space_left : (str_len - written);
-                if (chunk > 0) {
-                    memcpy(log_buffer + log_buffer_index, str + written, chunk);
-                    log_buffer_index += chunk;
-                    written += chunk;
-                }
-                if (written < str_len) {
-                    // Buffer full, flush and continue
-                    log_buffer[log_buffer_index] = '\0';
-                    log_func(log_buffer);
-                    log_buffer_index = 0;
-                }
-            }
-            // Always add a space after each argument
-            if (log_buffer_index < sizeof(log_buffer) - 2) {
-                log_buffer[log_buffer_index++] = ' ';
-            } else {
-                // Buffer full, flush and add space
-                log_buffer[log_buffer_index] = '\0';
-                log_func(log_buffer);
-                log_buffer_index = 0;
-                log_buffer[log_buffer_index++] = ' ';
-            }
-        }
-    }
-
-    // Add newline and flush
-    if (log_buffer_index < sizeof(log_buffer) - 1) {
-        log_buffer[log_buffer_index++] = '\n';
-    } else {
-        log_buffer[sizeof(log_buffer) - 2] = '\n';
-        log_buffer_index = sizeof(log_buffer) - 1;
-    }
-    log_buffer[log_buffer_index] = '\0';
-    log_func(log_buffer);
-
-    return 0;
-}
-
-// Lua function to draw a line between two points
-int lua_line(lua_State* L) {
-    if (lua_gettop(L) != 4) {
-        return 0;
-    }
-
-    int sourceX1 = (int)luaL_checknumber(L, 1);
-    int sourceY1 = (int)luaL_checknumber(L, 2);
-    int sourceX2 = (int)luaL_checknumber(L, 3);
-    int sourceY2 = (int)luaL_checknumber(L, 4);
-
-    draw_line(sourceX1, sourceY1, sourceX2, sourceY2);
-    return 0;
-}
-
-int lua_sprite_copy(lua_State* L, TARGET target) {
-    if (lua_gettop(L) != 8 && lua_gettop(L) != 9) {
-        return 0;
-    }
-
-    int sourceX = (int)luaL_checknumber(L, 1);
-    int sourceY = (int)luaL_checknumber(L, 2);
-    int sourceW = (int)luaL_checknumber(L, 3);
-    int sourceH = (int)luaL_checknumber(L, 4);
-
-    int targetX = (int)luaL_checknumber(L, 5);
-    int targetY = (int)luaL_checknumber(L, 6);
-    int targetW = (int)luaL_checknumber(L, 7);
-    int targetH = (int)luaL_checknumber(L, 8);
-
-    if(lua_gettop(L) == 8) {
-        draw_sprite(sourceX, sourceY, sourceW, sourceH, targetX, targetY, targetW, targetH, target);
-        return 0;
-    }
-
-    int targetR = (int)luaL_checknumber(L, 9);
-
-    draw_sprite_rotated(sourceX, sourceY, sourceW, sourceH, targetX, targetY, targetW, targetH, targetR, target);
-    return 0;
-}
-
-// Lua function to draw a sprite (with optional rotation).
-// Two call forms:
-//   sprite(n, x, y)                                  - draw the n-th 8x8 cell at (x, y)
-//   sprite(sx, sy, sw, sh, tx, ty, tw, th[, rot])    - full source/target region copy
-int lua_sprite(lua_State* L) {
-    if (lua_gettop(L) == 3) {
-        int n = (int)luaL_checknumber(L, 1);
-        int targetX = (int)luaL_checknumber(L, 2);
-        int targetY = (int)luaL_checknumber(L, 3);
-
-        // Spritesheet is TB_SCREEN_WIDTH x TB_SCREEN_HEIGHT laid out as 8x8 cells.
-        int cells_per_row = TB_SCREEN_WIDTH / 8;
-        int sourceX = (n % cells_per_row) * 8;
-        int sourceY = (n / cells_per_row) * 8;
-
-        draw_sprite(sourceX, sourceY, 8, 8, targetX, targetY, 8, 8, TARGET_SPRITESHEET);
-        return 0;
-    }
-    return lua_sprite_copy(L, TARGET_SPRITESHEET);
-}
-
-int lua_copy_disp(lua_State* L) {
-    return lua_sprite_copy(L, TARGET_DISPLAY);
-}
-
-// Lua function to get current frame time in milliseconds
-int lua_millis(lua_State* L) {
-    lua_Integer m = frame_time;
-    lua_pushinteger(L, m);
-    return 1;
-}
-
-// Lua function to generate random number within range
-int lua_random(lua_State* L) {
-    if (lua_gettop(L) != 2) {
-        return 0;
-    }
-
-    int min = (int)luaL_checknumber(L, 1);
-    int max = (int)luaL_checknumber(L, 2);
-
-    lua_pushinteger(L, random_range(min, max));
-    
-    return 1;
-}
-
-// Lua function: stroke(width, color) - set stroke width and color
-int lua_stroke(lua_State* L) {
-    if (lua_gettop(L) != 2) {
-        return 0;
-    }
-
-    int width = (int)luaL_checknumber(L, 1);
-    uint16_t color = (uint16_t)luaL_checkinteger(L, 2);
-
-    set_stroke(width, color);
-    return 0;
-}
-
-// Lua function: fill(color) - set fill color
-int lua_fill(lua_State* L) {
-    if (lua_gettop(L) != 1) {
-        return 0;
-    }
-
-    uint16_t color = (uint16_t)luaL_checkinteger(L, 1);
-    set_fill(color);
-    return 0;
-}
-
-// Lua function: text(color) - set text color
-int lua_text(lua_State* L) {
-    if (lua_gettop(L) != 1) {
-        return 0;
-    }
-
-    uint16_t color = (uint16_t)luaL_checkinteger(L, 1);
-    font_text_color(color);
-    return 0;
-}
-
-// Lua function: rgba(r, g, b, a) - pack into RGBA4444
-int lua_rgba(lua_State* L) {
-    int r = (int)luaL_checknumber(L, 1) & 0xFF;
-    int g = (int)luaL_checknumber(L, 2) & 0xFF;
-    int b = (int)luaL_checknumber(L, 3) & 0xFF;
-    int a = (int)luaL_checknumber(L, 4) & 0xFF;
-    lua_pushinteger(L, pack_color(r, g, b, a));
-    return 1;
-}
-
-// Lua function: rgb(r, g, b) - pack into RGBA4444 with alpha=255
-int lua_rgb(lua_State* L) {
-    int r = (int)luaL_checknumber(L, 1) & 0xFF;
-    int g = (int)luaL_checknumber(L, 2) & 0xFF;
-    int b = (int)luaL_checknumber(L, 3) & 0xFF;
-    lua_pushinteger(L, pack_color(r, g, b, 255));
-    return 1;
-}
-
-// Helper: convert HSB (all 0-255) to RGB (0-255)
-static void hsb_to_rgb(float h, float s, float b, int* r, int* g, int* bl) {
-    h = h * 360.0f / 255.0f;
-    s /= 255.0f;
-    b /= 255.0f;
-
-    float c = b * s;
-    float hh = h / 60.0;
-    float rem = hh - (int)(hh / 2.0) * 2.0;
-    float diff = rem - 1.0;
-    float x = c * (1.0 - (diff < 0 ? -diff : diff));
-    float m = b - c;
-
-    float rr, gg, bb;
-    if (h < 60)       { rr = c; gg = x; bb = 0; }
-    else if (h < 120) { rr = x; gg = c; bb = 0; }
-    else if (h < 180) { rr = 0; gg = c; bb = x; }
-    else if (h < 240) { rr = 0; gg = x; bb = c; }
-    else if (h < 300) { rr = x; gg = 0; bb = c; }
-    else              { rr = c; gg = 0; bb = x; }
-
-    *r = (int)((rr + m) * 255.0 + 0.5);
-    *g = (int)((gg + m) * 255.0 + 0.5);
-    *bl = (int)((bb + m) * 255.0 + 0.5);
-}
-
-// Lua function: hsba(h, s, b, a) - convert HSB + alpha to RGBA4444
-int lua_hsba(lua_State* L) {
-    float h = luaL_checknumber(L, 1);
-    float s = luaL_checknumber(L, 2);
-    float b = luaL_checknumber(L, 3);
-    int a = (int)luaL_checknumber(L, 4) & 0xFF;
-
-    int r, g, bl;
-    hsb_to_rgb(h, s, b, &r, &g, &bl);
-    lua_pushinteger(L, pack_color(r & 0xFF, g & 0xFF, bl & 0xFF, a));
-    return 1;
-}
-
-// Lua function: hsb(h, s, b) - convert HSB to RGBA4444 with alpha=255
-int lua_hsb(lua_State* L) {
-    float h = luaL_checknumber(L, 1);
-    float s = luaL_checknumber(L, 2);
-    float b = luaL_checknumber(L, 3);
-
-    int r, g, bl;
-    hsb_to_rgb(h, s, b, &r, &g, &bl);
-    lua_pushinteger(L, pack_color(r & 0xFF, g & 0xFF, bl & 0xFF, 255));
-    return 1;
-}
-
-// Lua function: pset(x, y, color) - set a pixel to a specific color
-int lua_pset(lua_State* L) {
-    if (lua_gettop(L) != 3) {
-        return 0;
-    }
-
-    int x = (int)luaL_checknumber(L, 1);
-    int y = (int)luaL_checknumber(L, 2);
-    uint16_t color = (uint16_t)luaL_checkinteger(L, 3);
-
-    pset(x, y, color);
-    return 0;
-}
-
-// Lua function: pget(x, y) - get the color of a pixel as RGBA4444
-int lua_pget(lua_State* L) {
-    if (lua_gettop(L) != 2) {
-        return 0;
-    }
-
-    int x = (int)luaL_checknumber(L, 1);
-    int y = (int)luaL_checknumber(L, 2);
-
-    uint16_t color = pget(x, y);
-    lua_pushinteger(L, color);
-    return 1;
-}
-
-// Lua function to draw a rectangle
-int lua_rect(lua_State* L) {
-    if (lua_gettop(L) != 4) {
-        return 0;
-    }
-
-    int x = (int)luaL_checknumber(L, 1);
-    int y = (int)luaL_checknumber(L, 2);
-    int w = (int)luaL_checknumber(L, 3);
-    int h = (int)luaL_checknumber(L, 4);
-
-    draw_rect(x, y, w, h);
-    return 0;
-}
-
-// Lua function to draw an oval
-int lua_oval(lua_State* L) {
-    if (lua_gettop(L) != 4) {
-        return 0;
-    }
-
-    int x = (int)luaL_checknumber(L, 1);
-    int y = (int)luaL_checknumber(L, 2);
-    int w = (int)luaL_checknumber(L, 3);
-    int h = (int)luaL_checknumber(L, 4);
-
-    draw_oval(x, y, w, h);
-    return 0;
-}
-
-// Lua function to add a point to polygon vertex list
-int lua_poly_add(lua_State* L) {
-    if (lua_gettop(L) != 2) {
-        return 0;
-    }
-
-    int x = (int)luaL_checknumber(L, 1);
-    int y = (int)luaL_checknumber(L, 2);
-
-    poly_add(x, y);
-    return 0;
-}
-
-// Lua function to clear polygon vertex list
-int lua_poly_clear(lua_State* L) {
-    poly_clear();
-    return 0;
-}
-
-// Lua function to draw the current polygon
-int lua_poly(lua_State* L) {
-    draw_polygon();
-    return 0;
-}
-
-// Lua function to check if button is currently pressed
-int lua_btn(lua_State* L) {
-    enum TinyBitButton btn = luaL_checkinteger(L, 1);
-    lua_pushboolean(L, input_btn(btn));
-    return 1;
-}
-
-// Lua function to check if button was just pressed this frame
-int lua_btnp(lua_State* L) {
-    enum TinyBitButton btn = luaL_checkinteger(L, 1);
-    lua_pushboolean(L, input_btnp(btn));
-    return 1;
-}
-
-// Lua function to clear the display
-int lua_cls(lua_State* L) {
-    draw_cls();
-    return 0;
-}
-
-// Lua function to copy memory between addresses
-int lua_mycopy(lua_State* L) {
-    if (lua_gettop(L) != 3) {
-        return 0;
-    }
-
-    int dst = luaL_checkinteger(L, 1);
-    int src = luaL_checkinteger(L, 2);
-    int size = luaL_checkinteger(L, 3);
-
-    mem_copy(dst, src, size);
-    return 0;
-}
-
-// Lua function to read a byte from memory
-int lua_peek(lua_State* L) {
-    if (lua_gettop(L) != 1) {
-        return 0;
-    }
-
-    int dst = luaL_checkinteger(L, 1);
-
-    lua_pushinteger(L, mem_peek(dst));
-    return 1;
-}
-
-// Lua function to write a byte to memory
-int lua_poke(lua_State* L) {
-    if (lua_gettop(L) != 2) {
-        return 0;
-    }
-
-    int dst = luaL_checkinteger(L, 1);
-    int val = luaL_checkinteger(L, 2);
-
-    mem_poke(dst, val);
-    return 0;
-}
-
-// Lua function to set text cursor position
-int lua_cursor(lua_State* L) {
-    if (lua_gettop(L) != 2) {
-        return 0;
-    }
-
-    int x = (int)luaL_checknumber(L, 1);
-    int y = (int)luaL_checknumber(L, 2);
-
-    font_cursor(x, y);
-    return 0;
-}
-
-// Lua function to print text at cursor position
-int lua_print(lua_State* L) {
-
-    if (lua_gettop(L) != 1) {
-        return 0;
-    }
-
-    const char* str = luaL_checkstring(L, 1);
-
-    font_print(str);
-    return 0;
-}
-
-// Lua function to play a music track
-int lua_music(lua_State* L) {
-
-    if (lua_gettop(L) != 1) {
-        return 0;
-    }
-
-    const char* str = luaL_checkstring(L, 1);
-
-    audio_load_abc(0, str, SINE, true);
-    return 0;
-}
-
-// Lua function to play a short sfx
-int lua_sfx(lua_State* L) {
-
-    if (lua_gettop(L) != 1) {
-        return 0;
-    }
-
-    const char* str = luaL_checkstring(L, 1);
-
-    audio_load_abc(1, str, SINE, false);
-    return 0;
-}
-
-int lua_sfx_active(lua_State* L) {
-    lua_pushboolean(L, is_channel_active(1));
-    return 1;
-}
-
-int lua_sleep(lua_State* L) {
-    int ms = luaL_checkinteger(L, 1);
-    tinybit_sleep(ms);
-    return 0;
+
+#include "lua/lua.h"
+#include "lua/lualib.h"
+#include "lua/lauxlib.h"
+
+#include <string.h>
+
+#include "lua_functions.h"
+#include "graphics.h"
+#include "memory.h"
+#include "font.h"
+#include "input.h"
+#include "audio.h"
+#include "tinybit.h"
+#include "stats.h"
+
+// Lua API bindings, registered as globals
+static const luaL_Reg api_bindings[] = {
+    {"sprite", lua_sprite},
+    {"sprites", lua_sprites},
+    {"map", lua_map},
+    {"mget", lua_mget},
+    {"mset", lua_mset},
+    {"duplicate", lua_copy_disp},
+    {"line", lua_line},
+    {"millis", lua_millis},
+    {"stroke", lua_stroke},
+    {"fill", lua_fill},
+    {"rect", lua_rect},
+    {"oval", lua_oval},
+    {"btn", lua_btn},
+    {"btnp", lua_btnp},
+    {"copy", lua_mycopy},
+    {"cls", lua_cls},
+    {"peek", lua_peek},
+    {"poke", lua_poke},
+    {"random", lua_random},
+    {"cursor", lua_cursor},
+    {"print", lua_print},
+    {"text", lua_text},
+    {"log", lua_log},
+    {"poly_add", lua_poly_add},
+    {"poly_clear", lua_poly_clear},
+    {"draw_polygon", lua_poly},
+    {"music", lua_music},
+    {"sfx", lua_sfx},
+    {"sfx_active", lua_sfx_active},
+    {"pset", lua_pset},
+    {"pget", lua_pget},
+    {"rgba", lua_rgba},
+    {"rgb", lua_rgb},
+    {"hsb", lua_hsb},
+    {"hsba", lua_hsba},
+    {"sleep", lua_sleep},
+    {"heapstats", lua_heapstats},
+    {NULL, NULL}
+};
+
+// A binding called through its accounting wrapper: upvalue 1 is its index
+static int lua_counted(lua_State* L) {
+    tinybit_ctx* ctx = tb_ctx(L);
+    int index = (int)lua_tointeger(L, lua_upvalueindex(1));
+    struct TinyBitApiStat* stat = &ctx->api.frame[index];
+    uint64_t pixels = ctx->api.pixels;
+    uint64_t start = stats_clock_us(ctx);
+
+    stat->calls++; // counted even if the binding raises an error
+    int results = api_bindings[index].func(L);
+    stat->time_us += (uint32_t)(stats_clock_us(ctx) - start);
+    stat->pixels += (uint32_t)(ctx->api.pixels - pixels);
+    return results;
+}
+
+// Set the binding globals, wrapped for accounting while it is enabled.
+// Called again when accounting is switched on or off.
+void lua_register_api(lua_State* L) {
+    tinybit_ctx* ctx = tb_ctx(L);
+
+    for (int i = 0; api_bindings[i].name; i++) {
+        if (ctx->api.enabled && i < TB_API_MAX_BINDINGS) {
+            lua_pushinteger(L, i);
+            lua_pushcclosure(L, lua_counted, 1);
+        } else {
+            lua_pushcfunction(L, api_bindings[i].func);
+        }
+        lua_setglobal(L, api_bindings[i].name);
+    }
+}
+
+// Finish a frame's accounting: it becomes the "last frame" the host reads
+void lua_api_end_frame(tinybit_ctx* ctx) {
+    memcpy(ctx->api.last, ctx->api.frame, sizeof(ctx->api.last));
+    for (int i = 0; i < ctx->api.count; i++) {
+        ctx->api.frame[i].calls = 0;
+        ctx->api.frame[i].time_us = 0;
+        ctx->api.frame[i].pixels = 0;
+    }
+}
+
+// Start or stop accounting; counters restart from zero
+void lua_api_enable(tinybit_ctx* ctx, bool enabled) {
+    ctx->api.enabled = enabled;
+    ctx->api.count = 0;
+    memset(ctx->api.frame, 0, sizeof(ctx->api.frame));
+    for (int i = 0; api_bindings[i].name && i < TB_API_MAX_BINDINGS; i++) {
+        ctx->api.frame[i].name = api_bindings[i].name;
+        ctx->api.count++;
+    }
+    memcpy(ctx->api.last, ctx->api.frame, sizeof(ctx->api.last));
+    if (ctx->L) {
+        lua_register_api(ctx->L);
+    }
+}
+
+// Initialize Lua state with TinyBit libraries and global variables
+void lua_setup(lua_State* L) {
+    
+    // load lua libraries
+    static const luaL_Reg loadedlibs[] = {
+        {LUA_GNAME, luaopen_base},
+        {LUA_COLIBNAME, luaopen_coroutine},
+        {LUA_TABLIBNAME, luaopen_table},
+        {LUA_STRLIBNAME, luaopen_string},
+        {LUA_MATHLIBNAME, luaopen_math},
+        {NULL, NULL}
+    };
+
+    const luaL_Reg* lib;
+    for (lib = loadedlibs; lib->func; lib++) {
+        luaL_requiref(L, lib->name, lib->func, 1);
+        lua_pop(L, 1);  /* remove lib */
+    }
+
+    // set lua waveforms
+    lua_pushinteger(L, SINE);
+    lua_setglobal(L, "SINE");
+    lua_pushinteger(L, SAW);
+    lua_setglobal(L, "SAW");
+    lua_pushinteger(L, SQUARE);
+    lua_setglobal(L, "SQUARE");
+    lua_pushinteger(L, NOISE);
+    lua_setglobal(L, "NOISE");
+
+    // sprite flags
+    lua_pushinteger(L, FLIP_X);
+    lua_setglobal(L, "FLIP_X");
+    lua_pushinteger(L, FLIP_Y);
+    lua_setglobal(L, "FLIP_Y");
+
+    lua_pushinteger(L, TB_MAP_WIDTH);
+    lua_setglobal(L, "TB_MAP_WIDTH");
+    lua_pushinteger(L, TB_MAP_HEIGHT);
+    lua_setglobal(L, "TB_MAP_HEIGHT");
+    lua_pushinteger(L, TB_SCREEN_WIDTH);
+    lua_setglobal(L, "TB_SCREEN_WIDTH");
+    lua_pushinteger(L, TB_SCREEN_HEIGHT);
+    lua_setglobal(L, "TB_SCREEN_HEIGHT");
+
+    lua_pushinteger(L, TB_BUTTON_A);
+	lua_setglobal(L, "A");
+	lua_pushinteger(L, TB_BUTTON_B);
+	lua_setglobal(L, "B");
+	lua_pushinteger(L, TB_BUTTON_UP);
+	lua_setglobal(L, "UP");
+	lua_pushinteger(L, TB_BUTTON_DOWN);
+	lua_setglobal(L, "DOWN");
+	lua_pushinteger(L, TB_BUTTON_LEFT);
+	lua_setglobal(L, "LEFT");
+	lua_pushinteger(L, TB_BUTTON_RIGHT);
+	lua_setglobal(L, "RIGHT");
+	lua_pushinteger(L, TB_BUTTON_START);
+	lua_setglobal(L, "START");
+    lua_pushinteger(L, TB_BUTTON_SELECT);
+	lua_setglobal(L, "SELECT");
+
+    lua_register_api(L);
+}
+
+// Lua function to log messages to the console
+int lua_log(lua_State* L) {
+    tinybit_ctx* ctx = tb_ctx(L);
+    char* log_buffer = ctx->log_buffer;
+    const size_t log_buffer_size = sizeof(ctx->log_buffer);
+
+    if (ctx->log_func == NULL) {
+        return 0; // No log function set
+    }
+
+    int log_buffer_index = 0;
+    int nargs = lua_gettop(L);
+
+    for (int i = 1; i <= nargs; i++) {
+        if (lua_isstring(L, i)) {
+            const char* str = lua_tostring(L, i);
+            size_t str_len = strlen(str);
+            size_t written = 0;
+            while (written < str_len) {
+                size_t space_left = log_buffer_size - log_buffer_index - 2; // reserve for space and null
+                size_t chunk = (str_len - written > space_left) ? space_left : (str_len - written);
+                if (chunk > 0) {
+                    memcpy(log_buffer + log_buffer_index, str + written, chunk);
+                    log_buffer_index += chunk;
+                    written += chunk;
+                }
+                if (written < str_len) {
+                    // Buffer full, flush and continue
+                    log_buffer[log_buffer_index] = '\0';
+                    ctx->log_func(ctx, log_buffer);
+                    log_buffer_index = 0;
+                }
+            }
+            // Always add a space after each argument
+            if (log_buffer_index < log_buffer_size - 2) {
+                log_buffer[log_buffer_index++] = ' ';
+            } else {
+                // Buffer full, flush and add space
+                log_buffer[log_buffer_index] = '\0';
+                ctx->log_func(ctx, log_buffer);
+                log_buffer_index = 0;
+                log_buffer[log_buffer_index++] = ' ';
+            }
+        }
+    }
+
+    // Add newline and flush
+    if (log_buffer_index < log_buffer_size - 1) {
+        log_buffer[log_buffer_index++] = '\n';
+    } else {
+        log_buffer[log_buffer_size - 2] = '\n';
+        log_buffer_index = log_buffer_size - 1;
+    }
+    log_buffer[log_buffer_index] = '\0';
+    ctx->log_func(ctx, log_buffer);
+
+    return 0;
+}
+
+// Lua function to draw a line between two points
+int lua_line(lua_State* L) {
+    if (lua_gettop(L) != 4) {
+        return 0;
+    }
+
+    int sourceX1 = (int)luaL_checknumber(L, 1);
+    int sourceY1 = (int)luaL_checknumber(L, 2);
+    int sourceX2 = (int)luaL_checknumber(L, 3);
+    int sourceY2 = (int)luaL_checknumber(L, 4);
+
+    draw_line(tb_ctx(L), sourceX1, sourceY1, sourceX2, sourceY2);
+    return 0;
+}
+
+int lua_sprite_copy(lua_State* L, TARGET target) {
+    if (lua_gettop(L) != 8 && lua_gettop(L) != 9) {
+        return 0;
+    }
+
+    int sourceX = (int)luaL_checknumber(L, 1);
+    int sourceY = (int)luaL_checknumber(L, 2);
+    int sourceW = (int)luaL_checknumber(L, 3);
+    int sourceH = (int)luaL_checknumber(L, 4);
+
+    int targetX = (int)luaL_checknumber(L, 5);
+    int targetY = (int)luaL_checknumber(L, 6);
+    int targetW = (int)luaL_checknumber(L, 7);
+    int targetH = (int)luaL_checknumber(L, 8);
+
+    if(lua_gettop(L) == 8) {
+        draw_sprite(tb_ctx(L), sourceX, sourceY, sourceW, sourceH, targetX, targetY, targetW, targetH, target);
+        return 0;
+    }
+
+    int targetR = (int)luaL_checknumber(L, 9);
+
+    draw_sprite_rotated(tb_ctx(L), sourceX, sourceY, sourceW, sourceH, targetX, targetY, targetW, targetH, targetR, target);
+    return 0;
+}
+
+// Lua function to draw a sprite (with optional rotation).
+// Two call forms:
+//   sprite(n, x, y)                                  - draw the n-th 8x8 cell at (x, y)
+//   sprite(sx, sy, sw, sh, tx, ty, tw, th[, rot])    - full source/target region copy
+int lua_sprite(lua_State* L) {
+    if (lua_gettop(L) == 3) {
+        int n = (int)luaL_checknumber(L, 1);
+        int targetX = (int)luaL_checknumber(L, 2);
+        int targetY = (int)luaL_checknumber(L, 3);
+
+        draw_cell(tb_ctx(L), n, targetX, targetY, 0);
+        return 0;
+    }
+    return lua_sprite_copy(L, TARGET_SPRITESHEET);
+}
+
+static int16_t read_i16(const uint8_t* p) {
+    return (int16_t)(p[0] | (p[1] << 8));
+}
+
+// Lua function to draw a batch of 8x8 cells in one call:
+//   sprites(records [, count])
+// records is either a flat table {n, x, y, flags, n, x, y, flags, ...} that
+// can be refilled every frame, or a string of little-endian int16 records
+// as built by string.pack("<i2i2i2i2", n, x, y, flags). count limits how
+// many records are drawn, so a larger table can be reused.
+int lua_sprites(lua_State* L) {
+    tinybit_ctx* ctx = tb_ctx(L);
+    lua_Integer count = luaL_optinteger(L, 2, -1);
+
+    if (lua_type(L, 1) == LUA_TSTRING) {
+        size_t size;
+        const uint8_t* record = (const uint8_t*)lua_tolstring(L, 1, &size);
+        lua_Integer available = (lua_Integer)(size / 8);
+        if (count < 0 || count > available) count = available;
+
+        for (lua_Integer i = 0; i < count; i++, record += 8) {
+            draw_cell(ctx, read_i16(record), read_i16(record + 2), read_i16(record + 4), read_i16(record + 6));
+        }
+        return 0;
+    }
+
+    luaL_checktype(L, 1, LUA_TTABLE);
+    lua_Integer available = (lua_Integer)(lua_rawlen(L, 1) / 4);
+    if (count < 0 || count > available) count = available;
+
+    for (lua_Integer i = 0; i < count; i++) {
+        lua_Integer base = i * 4;
+        lua_rawgeti(L, 1, base + 1);
+        lua_rawgeti(L, 1, base + 2);
+        lua_rawgeti(L, 1, base + 3);
+        lua_rawgeti(L, 1, base + 4);
+        draw_cell(ctx, (int)lua_tonumber(L, -4), (int)lua_tonumber(L, -3),
+                  (int)lua_tonumber(L, -2), (int)lua_tonumber(L, -1));
+        lua_pop(L, 4);
+    }
+    return 0;
+}
+
+// Lua function to draw a block of the tilemap:
+//   map(cx, cy [, sx, sy [, w, h]])
+// draws w x h cells (default: a screenful) from map cell (cx, cy) at (sx, sy)
+int lua_map(lua_State* L) {
+    int cellX = (int)luaL_checknumber(L, 1);
+    int cellY = (int)luaL_checknumber(L, 2);
+    int targetX = (int)luaL_optnumber(L, 3, 0);
+    int targetY = (int)luaL_optnumber(L, 4, 0);
+    int cellW = (int)luaL_optnumber(L, 5, TB_SCREEN_WIDTH / 8);
+    int cellH = (int)luaL_optnumber(L, 6, TB_SCREEN_HEIGHT / 8);
+
+    draw_map(tb_ctx(L), cellX, cellY, targetX, targetY, cellW, cellH);
+    return 0;
+}
+
+// Lua function to read a tilemap cell; 0 outside the map
+int lua_mget(lua_State* L) {
+    int x = (int)luaL_checknumber(L, 1);
+    int y = (int)luaL_checknumber(L, 2);
+
+    if (x < 0 || x >= TB_MAP_WIDTH || y < 0 || y >= TB_MAP_HEIGHT) {
+        lua_pushinteger(L, 0);
+        return 1;
+    }
+    lua_pushinteger(L, tb_ctx(L)->memory->tilemap[y * TB_MAP_WIDTH + x]);
+    return 1;
+}
+
+// Lua function to write a tilemap cell
+int lua_mset(lua_State* L) {
+    int x = (int)luaL_checknumber(L, 1);
+    int y = (int)luaL_checknumber(L, 2);
+    int n = (int)luaL_checkinteger(L, 3);
+
+    if (x < 0 || x >= TB_MAP_WIDTH || y < 0 || y >= TB_MAP_HEIGHT) {
+        return 0;
+    }
+    tb_ctx(L)->memory->tilemap[y * TB_MAP_WIDTH + x] = (uint8_t)n;
+    return 0;
+}
+
+int lua_copy_disp(lua_State* L) {
+    return lua_sprite_copy(L, TARGET_DISPLAY);
+}
+
+// Lua function to get current frame time in milliseconds
+int lua_millis(lua_State* L) {
+    lua_Integer m = tb_ctx(L)->frame_time;
+    lua_pushinteger(L, m);
+    return 1;
+}
+
+// Lua function to generate random number within range
+int lua_random(lua_State* L) {
+    if (lua_gettop(L) != 2) {
+        return 0;
+    }
+
+    int min = (int)luaL_checknumber(L, 1);
+    int max = (int)luaL_checknumber(L, 2);
+
+    lua_pushinteger(L, random_range(tb_ctx(L), min, max));
+    
+    return 1;
+}
+
+// Lua function: stroke(width, color) - set stroke width and color
+int lua_stroke(lua_State* L) {
+    if (lua_gettop(L) != 2) {
+        return 0;
+    }
+
+    int width = (int)luaL_checknumber(L, 1);
+    uint16_t color = (uint16_t)luaL_checkinteger(L, 2);
+
+    set_stroke(tb_ctx(L), width, color);
+    return 0;
+}
+
+// Lua function: fill(color) - set fill color
+int lua_fill(lua_State* L) {
+    if (lua_gettop(L) != 1) {
+        return 0;
+    }
+
+    uint16_t color = (uint16_t)luaL_checkinteger(L, 1);
+    set_fill(tb_ctx(L), color);
+    return 0;
+}
+
+// Lua function: text(color) - set text color
+int lua_text(lua_State* L) {
+    if (lua_gettop(L) != 1) {
+        return 0;
+    }
+
+    uint16_t color = (uint16_t)luaL_checkinteger(L, 1);
+    font_text_color(tb_ctx(L), color);
+    return 0;
+}
+
+// Lua function: rgba(r, g, b, a) - pack into RGBA4444
+int lua_rgba(lua_State* L) {
+    int r = (int)luaL_checknumber(L, 1) & 0xFF;
+    int g = (int)luaL_checknumber(L, 2) & 0xFF;
+    int b = (int)luaL_checknumber(L, 3) & 0xFF;
+    int a = (int)luaL_checknumber(L, 4) & 0xFF;
+    lua_pushinteger(L, pack_color(r, g, b, a));
+    return 1;
+}
+
+// Lua function: rgb(r, g, b) - pack into RGBA4444 with alpha=255
+int lua_rgb(lua_State* L) {
+    int r = (int)luaL_checknumber(L, 1) & 0xFF;
+    int g = (int)luaL_checknumber(L, 2) & 0xFF;
+    int b = (int)luaL_checknumber(L, 3) & 0xFF;
+    lua_pushinteger(L, pack_color(r, g, b, 255));
+    return 1;
+}
+
+// Helper: convert HSB (all 0-255) to RGB (0-255)
+static void hsb_to_rgb(float h, float s, float b, int* r, int* g, int* bl) {
+    h = h * 360.0f / 255.0f;
+    s /= 255.0f;
+    b /= 255.0f;
+
+    float c = b * s;
+    float hh = h / 60.0;
+    float rem = hh - (int)(hh / 2.0) * 2.0;
+    float diff = rem - 1.0;
+    float x = c * (1.0 - (diff < 0 ? -diff : diff));
+    float m = b - c;
+
+    float rr, gg, bb;
+    if (h < 60)       { rr = c; gg = x; bb = 0; }
+    else if (h < 120) { rr = x; gg = c; bb = 0; }
+    else if (h < 180) { rr = 0; gg = c; bb = x; }
+    else if (h < 240) { rr = 0; gg = x; bb = c; }
+    else if (h < 300) { rr = x; gg = 0; bb = c; }
+    else              { rr = c; gg = 0; bb = x; }
+
+    *r = (int)((rr + m) * 255.0 + 0.5);
+    *g = (int)((gg + m) * 255.0 + 0.5);
+    *bl = (int)((bb + m) * 255.0 + 0.5);
+}
+
+// Lua function: hsba(h, s, b, a) - convert HSB + alpha to RGBA4444
+int lua_hsba(lua_State* L) {
+    float h = luaL_checknumber(L, 1);
+    float s = luaL_checknumber(L, 2);
+    float b = luaL_checknumber(L, 3);
+    int a = (int)luaL_checknumber(L, 4) & 0xFF;
+
+    int r, g, bl;
+    hsb_to_rgb(h, s, b, &r, &g, &bl);
+    lua_pushinteger(L, pack_color(r & 0xFF, g & 0xFF, bl & 0xFF, a));
+    return 1;
+}
+
+// Lua function: hsb(h, s, b) - convert HSB to RGBA4444 with alpha=255
+int lua_hsb(lua_State* L) {
+    float h = luaL_checknumber(L, 1);
+    float s = luaL_checknumber(L, 2);
+    float b = luaL_checknumber(L, 3);
+
+    int r, g, bl;
+    hsb_to_rgb(h, s, b, &r, &g, &bl);
+    lua_pushinteger(L, pack_color(r & 0xFF, g & 0xFF, bl & 0xFF, 255));
+    return 1;
+}
+
+// Lua function: pset(x, y, color) - set a pixel to a specific color
+int lua_pset(lua_State* L) {
+    if (lua_gettop(L) != 3) {
+        return 0;
+    }
+
+    int x = (int)luaL_checknumber(L, 1);
+    int y = (int)luaL_checknumber(L, 2);
+    uint16_t color = (uint16_t)luaL_checkinteger(L, 3);
+
+    pset(tb_ctx(L), x, y, color);
+    return 0;
+}
+
+// Lua function: pget(x, y) - get the color of a pixel as RGBA4444
+int lua_pget(lua_State* L) {
+    if (lua_gettop(L) != 2) {
+        return 0;
+    }
+
+    int x = (int)luaL_checknumber(L, 1);
+    int y = (int)luaL_checknumber(L, 2);
+
+    uint16_t color = pget(tb_ctx(L), x, y);
+    lua_pushinteger(L, color);
+    return 1;
+}
+
+// Lua function to draw a rectangle
+int lua_rect(lua_State* L) {
+    if (lua_gettop(L) != 4) {
+        return 0;
+    }
+
+    int x = (int)luaL_checknumber(L, 1);
+    int y = (int)luaL_checknumber(L, 2);
+    int w = (int)luaL_checknumber(L, 3);
+    int h = (int)luaL_checknumber(L, 4);
+
+    draw_rect(tb_ctx(L), x, y, w, h);
+    return 0;
+}
+
+// Lua function to draw an oval
+int lua_oval(lua_State* L) {
+    if (lua_gettop(L) != 4) {
+        return 0;
+    }
+
+    int x = (int)luaL_checknumber(L, 1);
+    int y = (int)luaL_checknumber(L, 2);
+    int w = (int)luaL_checknumber(L, 3);
+    int h = (int)luaL_checknumber(L, 4);
+
+    draw_oval(tb_ctx(L), x, y, w, h);
+    return 0;
+}
+
+// Lua function to add a point to polygon vertex list
+int lua_poly_add(lua_State* L) {
+    if (lua_gettop(L) != 2) {
+        return 0;
+    }
+
+    int x = (int)luaL_checknumber(L, 1);
+    int y = (int)luaL_checknumber(L, 2);
+
+    poly_add(tb_ctx(L), x, y);
+    return 0;
+}
+
+// Lua function to clear polygon vertex list
+int lua_poly_clear(lua_State* L) {
+    poly_clear(tb_ctx(L));
+    return 0;
+}
+
+// Lua function to draw the current polygon
+int lua_poly(lua_State* L) {
+    draw_polygon(tb_ctx(L));
+    return 0;
+}
+
+// Lua function to check if button is currently pressed
+int lua_btn(lua_State* L) {
+    enum TinyBitButton btn = luaL_checkinteger(L, 1);
+    lua_pushboolean(L, input_btn(tb_ctx(L), btn));
+    return 1;
+}
+
+// Lua function to check if button was just pressed this frame
+int lua_btnp(lua_State* L) {
+    enum TinyBitButton btn = luaL_checkinteger(L, 1);
+    lua_pushboolean(L, input_btnp(tb_ctx(L), btn));
+    return 1;
+}
+
+// Lua function to clear the display
+int lua_cls(lua_State* L) {
+    draw_cls(tb_ctx(L));
+    return 0;
+}
+
+// Lua function to copy memory between addresses
+int lua_mycopy(lua_State* L) {
+    if (lua_gettop(L) != 3) {
+        return 0;
+    }
+
+    int dst = luaL_checkinteger(L, 1);
+    int src = luaL_checkinteger(L, 2);
+    int size = luaL_checkinteger(L, 3);
+
+    mem_copy(tb_ctx(L), dst, src, size);
+    return 0;
+}
+
+// Lua function to read a byte from memory
+int lua_peek(lua_State* L) {
+    if (lua_gettop(L) != 1) {
+        return 0;
+    }
+
+    int dst = luaL_checkinteger(L, 1);
+
+    lua_pushinteger(L, mem_peek(tb_ctx(L), dst));
+    return 1;
+}
+
+// Lua function to write a byte to memory
+int lua_poke(lua_State* L) {
+    if (lua_gettop(L) != 2) {
+        return 0;
+    }
+
+    int dst = luaL_checkinteger(L, 1);
+    int val = luaL_checkinteger(L, 2);
+
+    mem_poke(tb_ctx(L), dst, val);
+    return 0;
+}
+
+// Lua function to set text cursor position
+int lua_cursor(lua_State* L) {
+    if (lua_gettop(L) != 2) {
+        return 0;
+    }
+
+    int x = (int)luaL_checknumber(L, 1);
+    int y = (int)luaL_checknumber(L, 2);
+
+    font_cursor(tb_ctx(L), x, y);
+    return 0;
+}
+
+// Lua function to print text at cursor position
+int lua_print(lua_State* L) {
+
+    if (lua_gettop(L) != 1) {
+        return 0;
+    }
+
+    const char* str = luaL_checkstring(L, 1);
+
+    font_print(tb_ctx(L), str);
+    return 0;
+}
+
+// Lua function to play a music track
+int lua_music(lua_State* L) {
+
+    if (lua_gettop(L) != 1) {
+        return 0;
+    }
+
+    const char* str = luaL_checkstring(L, 1);
+
+    audio_load_abc(tb_ctx(L), 0, str, SINE, true);
+    return 0;
+}
+
+// Lua function to play a short sfx
+int lua_sfx(lua_State* L) {
+
+    if (lua_gettop(L) != 1) {
+        return 0;
+    }
+
+    const char* str = luaL_checkstring(L, 1);
+
+    audio_load_abc(tb_ctx(L), 1, str, SINE, false);
+    return 0;
+}
+
+int lua_sfx_active(lua_State* L) {
+    lua_pushboolean(L, is_channel_active(tb_ctx(L), 1));
+    return 1;
+}
+
+int lua_sleep(lua_State* L) {
+    int ms = luaL_checkinteger(L, 1);
+    tinybit_sleep(tb_ctx(L), ms);
+    return 0;
+}
+
+// Lua heap telemetry as a table; allocs[i] counts requests up to 8 << i bytes
+int lua_heapstats(lua_State* L) {
+    struct TinyBitHeapStats stats;
+    tinybit_lua_heap_stats(tb_ctx(L), &stats);
+
+    lua_createtable(L, 0, 10);
+    lua_pushinteger(L, (lua_Integer)stats.capacity);
+    lua_setfield(L, -2, "capacity");
+    lua_pushinteger(L, (lua_Integer)stats.used);
+    lua_setfield(L, -2, "used");
+    lua_pushinteger(L, (lua_Integer)stats.peak);
+    lua_setfield(L, -2, "peak");
+    lua_pushinteger(L, (lua_Integer)stats.free_bytes);
+    lua_setfield(L, -2, "free");
+    lua_pushinteger(L, (lua_Integer)stats.largest_free);
+    lua_setfield(L, -2, "largest_free");
+    lua_pushinteger(L, (lua_Integer)stats.free_blocks);
+    lua_setfield(L, -2, "free_blocks");
+    lua_pushnumber(L, stats.fragmentation);
+    lua_setfield(L, -2, "fragmentation");
+    lua_pushinteger(L, (lua_Integer)stats.failed_allocations);
+    lua_setfield(L, -2, "failed");
+    lua_pushinteger(L, (lua_Integer)stats.dropped_frames);
+    lua_setfield(L, -2, "dropped_frames");
+
+    lua_createtable(L, TB_HEAP_BUCKETS, 0);
+    for (int i = 0; i < TB_HEAP_BUCKETS; i++) {
+        lua_pushinteger(L, (lua_Integer)stats.allocations[i]);
+        lua_rawseti(L, -2, i + 1);
+    }
+    lua_setfield(L, -2, "allocs");
+    return 1;
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include <stdbool.h>
 #include <string.h>
+#include <time.h>
 
 #include "lua/lua.h"
 #include "lua/lualib.h"
@@ -9,121 +10,810 @@
 
 #include "lua_functions.h"
 #include "memory.h"
+#include "stats.h"
+
+#define GC_FRAME_STEPMUL  2
+#define GC_FRAME_SLICE_KB 4
+
+// Segregated-fit allocator over memory->lua_state. Free blocks sit in
+// doubly linked lists by size class, and a bitmap of non-empty classes
+// finds a big enough block without walking the heap. Small sizes get one
+// class per 8 bytes; above SMALL_LIMIT each power of two is split into
+// SUBCLASSES ranges. The bins live at the start of the arena.
+//
+// Free blocks also end in a footer holding their size, and every header
+// records whether the block before it is free, so pool_free can find and
+// merge both neighbours in constant time.
+//
+// Small objects (strings, tables, closures, upvalues, call frames) come
+// from slabs instead: SLAB_PAGE_SIZE pages taken from the block allocator
+// at page-aligned offsets and cut into equal objects of one size class.
+// A bitmap over the arena marks slab pages, so any pointer can be told
+// apart in constant time on free.
 
 typedef struct BlockHeader {
-    size_t size;  // usable size (excluding header)
+    size_t size;     // usable size (excluding header)
     bool free;
+    bool prev_free;  // the physically previous block is free (and has a footer)
+    bool slab;       // the block is a slab page
 } BlockHeader;
 
+// a free block's payload links it into its bin
+typedef struct FreeLinks {
+    BlockHeader *next;
+    BlockHeader *prev;
+} FreeLinks;
+
 #define BLOCK_HDR_SIZE (sizeof(BlockHeader))
-#define MIN_BLOCK_SIZE 8
+#define FOOTER_SIZE    (sizeof(size_t))
+#define MIN_BLOCK_SIZE (sizeof(FreeLinks) + FOOTER_SIZE)
+#define ALIGN_UP(n)    (((n) + sizeof(void*) - 1) & ~(sizeof(void*) - 1))
+
+#define SMALL_STEP     8
+#define SMALL_LIMIT    256
+#define SMALL_BINS     (SMALL_LIMIT / SMALL_STEP)
+#define SMALL_LOG2     8   // log2(SMALL_LIMIT)
+#define SUBCLASS_LOG2  2
+#define SUBCLASSES     (1 << SUBCLASS_LOG2)
+#define BIN_COUNT      (SMALL_BINS + (32 - SMALL_LOG2) * SUBCLASSES)
+#define BITMAP_WORDS   (BIN_COUNT / 32)
+
+#define SLAB_STEP      8
+#define SLAB_MAX       (TB_SLAB_CLASSES * SLAB_STEP)
+#define SLAB_PAGE_SIZE 1024
+#define SLAB_PAGES     (TB_MEM_LUA_STATE_SIZE / SLAB_PAGE_SIZE)
+
+// Start of a slab page's payload; objects follow it
+typedef struct SlabPage {
+    struct SlabPage *next;  // pages of this class with free objects
+    struct SlabPage *prev;
+    void *free;             // free objects, linked through their first word
+    uint16_t cls;
+    uint16_t used;
+} SlabPage;
+
+typedef struct SlabClass {
+    SlabPage *partial;
+    uint32_t pages;
+    uint32_t used;
+} SlabClass;
 
-static bool lua_heap_initialized = false;
-static size_t lua_heap_used = 0;
+typedef struct PoolControl {
+    uint32_t bitmap[BITMAP_WORDS];
+    BlockHeader *bins[BIN_COUNT];
+    SlabClass slabs[TB_SLAB_CLASSES];
+    uint32_t slab_map[SLAB_PAGES / 32];  // arena pages that are slab pages
+} PoolControl;
 
-static void lua_heap_init(void) {
-    BlockHeader *first = (BlockHeader *)tinybit_memory->lua_state;
-    first->size = TB_MEM_LUA_STATE_SIZE - BLOCK_HDR_SIZE;
-    first->free = true;
-    lua_heap_initialized = true;
-    lua_heap_used = 0;
+#define HEAP_START     ALIGN_UP(sizeof(PoolControl))
+
+static int lowest_bit(uint32_t x) {
+#if defined(__GNUC__)
+    return __builtin_ctz(x);
+#else
+    int n = 0;
+    while (!(x & 1)) { x >>= 1; n++; }
+    return n;
+#endif
 }
 
-static void *pool_alloc(size_t size) {
-    // align to pointer size
-    size = (size + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+static int floor_log2(size_t x) {
+    int n = 0;
+    while (x >>= 1) n++;
+    return n;
+}
 
-    uint8_t *pos = tinybit_memory->lua_state;
-    while (pos < tinybit_memory->lua_state + TB_MEM_LUA_STATE_SIZE) {
-        BlockHeader *hdr = (BlockHeader *)pos;
-        if (hdr->free && hdr->size >= size) {
-            // split if remaining space is large enough
-            if (hdr->size >= size + BLOCK_HDR_SIZE + MIN_BLOCK_SIZE) {
-                BlockHeader *next = (BlockHeader *)(pos + BLOCK_HDR_SIZE + size);
-                next->size = hdr->size - size - BLOCK_HDR_SIZE;
-                next->free = true;
-                hdr->size = size;
-            }
-            hdr->free = false;
-            lua_heap_used += hdr->size;
-            return pos + BLOCK_HDR_SIZE;
+static PoolControl *pool_control(tinybit_ctx* ctx) {
+    return (PoolControl *)ctx->memory->lua_state;
+}
+
+static FreeLinks *links(BlockHeader *hdr) {
+    return (FreeLinks *)((uint8_t *)hdr + BLOCK_HDR_SIZE);
+}
+
+static uint8_t *heap_end(tinybit_ctx* ctx) {
+    return ctx->memory->lua_state + TB_MEM_LUA_STATE_SIZE;
+}
+
+// The physically next block, or NULL at the end of the arena
+static BlockHeader *next_block(tinybit_ctx* ctx, BlockHeader *hdr) {
+    uint8_t *next = (uint8_t *)hdr + BLOCK_HDR_SIZE + hdr->size;
+    return next < heap_end(ctx) ? (BlockHeader *)next : NULL;
+}
+
+// Only valid when hdr->prev_free is set
+static BlockHeader *prev_block(BlockHeader *hdr) {
+    size_t prev_size = *(size_t *)((uint8_t *)hdr - FOOTER_SIZE);
+    return (BlockHeader *)((uint8_t *)hdr - prev_size - BLOCK_HDR_SIZE);
+}
+
+// Set a block's free state and keep its footer and the next header in step
+static void mark_block(tinybit_ctx* ctx, BlockHeader *hdr, bool free) {
+    hdr->free = free;
+    if (free) {
+        *(size_t *)((uint8_t *)hdr + BLOCK_HDR_SIZE + hdr->size - FOOTER_SIZE) = hdr->size;
+    }
+    BlockHeader *next = next_block(ctx, hdr);
+    if (next) {
+        next->prev_free = free;
+    }
+}
+
+// The class a block of this size is filed under
+static int bin_index(size_t size) {
+    if (size < SMALL_LIMIT) {
+        return (int)(size / SMALL_STEP);
+    }
+    int log2 = floor_log2(size);
+    int sub = (int)(size >> (log2 - SUBCLASS_LOG2)) & (SUBCLASSES - 1);
+    return SMALL_BINS + (log2 - SMALL_LOG2) * SUBCLASSES + sub;
+}
+
+// The first class whose blocks are all at least size bytes
+static int fit_index(size_t size) {
+    if (size >= SMALL_LIMIT) {
+        size += ((size_t)1 << (floor_log2(size) - SUBCLASS_LOG2)) - 1;
+    } else {
+        size += SMALL_STEP - 1;
+    }
+    return bin_index(size);
+}
+
+static void bin_insert(PoolControl *pc, BlockHeader *hdr) {
+    int i = bin_index(hdr->size);
+    FreeLinks *l = links(hdr);
+    l->prev = NULL;
+    l->next = pc->bins[i];
+    if (l->next) {
+        links(l->next)->prev = hdr;
+    }
+    pc->bins[i] = hdr;
+    pc->bitmap[i / 32] |= 1u << (i % 32);
+}
+
+static void bin_remove(PoolControl *pc, BlockHeader *hdr) {
+    int i = bin_index(hdr->size);
+    FreeLinks *l = links(hdr);
+    if (l->prev) {
+        links(l->prev)->next = l->next;
+    } else {
+        pc->bins[i] = l->next;
+        if (!l->next) {
+            pc->bitmap[i / 32] &= ~(1u << (i % 32));
+        }
+    }
+    if (l->next) {
+        links(l->next)->prev = l->prev;
+    }
+}
+
+// Head of the first non-empty class at or above index, or NULL
+static BlockHeader *bin_search(PoolControl *pc, int index) {
+    for (int w = index / 32; w < BITMAP_WORDS; w++) {
+        uint32_t bits = pc->bitmap[w];
+        if (w == index / 32) {
+            bits &= ~0u << (index % 32);
+        }
+        if (bits) {
+            return pc->bins[w * 32 + lowest_bit(bits)];
         }
-        pos += BLOCK_HDR_SIZE + hdr->size;
     }
-    return NULL; // out of memory
+    return NULL;
 }
 
-static void pool_free(void *ptr) {
-    if (!ptr) return;
+// First block of at least size bytes in class index, or NULL. Only the
+// request's own class mixes blocks smaller and larger than it.
+static BlockHeader *bin_scan(PoolControl *pc, int index, size_t size) {
+    for (BlockHeader *hdr = pc->bins[index]; hdr; hdr = links(hdr)->next) {
+        if (hdr->size >= size) {
+            return hdr;
+        }
+    }
+    return NULL;
+}
 
-    BlockHeader *hdr = (BlockHeader *)((uint8_t *)ptr - BLOCK_HDR_SIZE);
-    hdr->free = true;
-    lua_heap_used -= hdr->size;
+static void lua_heap_init(tinybit_ctx* ctx) {
+    PoolControl *pc = pool_control(ctx);
+    memset(pc, 0, sizeof(*pc));
+
+    BlockHeader *first = (BlockHeader *)(ctx->memory->lua_state + HEAP_START);
+    first->size = TB_MEM_LUA_STATE_SIZE - HEAP_START - BLOCK_HDR_SIZE;
+    first->prev_free = false;
+    mark_block(ctx, first, true);
+    bin_insert(pc, first);
+
+    ctx->lua_heap.initialized = true;
+    ctx->lua_heap.used = 0;
+}
+
+// Request size rounded to what a block actually holds
+static size_t block_size(size_t size) {
+    size = ALIGN_UP(size);
+    return size < MIN_BLOCK_SIZE ? MIN_BLOCK_SIZE : size;
+}
+
+static void heap_grew(tinybit_ctx* ctx, size_t bytes) {
+    ctx->lua_heap.used += bytes;
+    if (ctx->lua_heap.used > ctx->heap_stats.peak) {
+        ctx->heap_stats.peak = ctx->lua_heap.used;
+    }
+}
+
+// Trim an in-use block to size if the rest can form a block of its own.
+// The rest is freed and merged with a free successor.
+static void split_block(tinybit_ctx* ctx, BlockHeader *hdr, size_t size) {
+    if (hdr->size < size + BLOCK_HDR_SIZE + MIN_BLOCK_SIZE) {
+        return;
+    }
+
+    PoolControl *pc = pool_control(ctx);
+    BlockHeader *rest = (BlockHeader *)((uint8_t *)hdr + BLOCK_HDR_SIZE + size);
+    rest->size = hdr->size - size - BLOCK_HDR_SIZE;
+    rest->prev_free = false;
+    hdr->size = size;
+
+    BlockHeader *next = next_block(ctx, rest);
+    if (next && next->free) {
+        bin_remove(pc, next);
+        rest->size += BLOCK_HDR_SIZE + next->size;
+    }
+    mark_block(ctx, rest, true);
+    bin_insert(pc, rest);
+}
+
+static void *pool_alloc(tinybit_ctx* ctx, size_t size) {
+    PoolControl *pc = pool_control(ctx);
+
+    if (size > TB_MEM_LUA_STATE_SIZE) {
+        return NULL;
+    }
+    size = block_size(size);
+
+    BlockHeader *hdr = bin_search(pc, fit_index(size));
+    if (!hdr) {
+        hdr = bin_scan(pc, bin_index(size), size);
+    }
+    if (!hdr) {
+        return NULL; // out of memory
+    }
+    bin_remove(pc, hdr);
+
+    split_block(ctx, hdr, size);
+    mark_block(ctx, hdr, false);
+    hdr->slab = false;
+    heap_grew(ctx, hdr->size);
+    return (uint8_t *)hdr + BLOCK_HDR_SIZE;
+}
+
+// Return a block to the bins, merged with free neighbours
+static void release_block(tinybit_ctx* ctx, BlockHeader *hdr) {
+    PoolControl *pc = pool_control(ctx);
 
     // coalesce with next block
-    uint8_t *next_pos = (uint8_t *)ptr + hdr->size;
-    if (next_pos < tinybit_memory->lua_state + TB_MEM_LUA_STATE_SIZE) {
-        BlockHeader *next = (BlockHeader *)next_pos;
-        if (next->free) {
-            hdr->size += BLOCK_HDR_SIZE + next->size;
+    BlockHeader *next = next_block(ctx, hdr);
+    if (next && next->free) {
+        bin_remove(pc, next);
+        hdr->size += BLOCK_HDR_SIZE + next->size;
+    }
+
+    // coalesce with previous block
+    if (hdr->prev_free) {
+        BlockHeader *prev = prev_block(hdr);
+        bin_remove(pc, prev);
+        prev->size += BLOCK_HDR_SIZE + hdr->size;
+        hdr = prev;
+    }
+
+    mark_block(ctx, hdr, true);
+    bin_insert(pc, hdr);
+}
+
+static void pool_free(tinybit_ctx* ctx, void *ptr) {
+    BlockHeader *hdr = (BlockHeader *)((uint8_t *)ptr - BLOCK_HDR_SIZE);
+    ctx->lua_heap.used -= hdr->size;
+    release_block(ctx, hdr);
+}
+
+static size_t slab_object_size(int cls) {
+    return (size_t)(cls + 1) * SLAB_STEP;
+}
+
+static int slab_objects_per_page(int cls) {
+    return (int)((SLAB_PAGE_SIZE - BLOCK_HDR_SIZE - ALIGN_UP(sizeof(SlabPage))) / slab_object_size(cls));
+}
+
+// The slab page holding ptr, or NULL if ptr is a regular block
+static SlabPage *slab_page_of(tinybit_ctx* ctx, void *ptr) {
+    size_t page = (size_t)((uint8_t *)ptr - ctx->memory->lua_state) / SLAB_PAGE_SIZE;
+    if (!((pool_control(ctx)->slab_map[page / 32] >> (page % 32)) & 1)) {
+        return NULL;
+    }
+    return (SlabPage *)(ctx->memory->lua_state + page * SLAB_PAGE_SIZE + BLOCK_HDR_SIZE);
+}
+
+static void slab_list_remove(SlabClass *sc, SlabPage *page) {
+    if (page->prev) page->prev->next = page->next;
+    else sc->partial = page->next;
+    if (page->next) page->next->prev = page->prev;
+}
+
+static void slab_list_push(SlabClass *sc, SlabPage *page) {
+    page->prev = NULL;
+    page->next = sc->partial;
+    if (page->next) page->next->prev = page;
+    sc->partial = page;
+}
+
+// Take a block whose header sits on a page boundary of the arena, so the
+// whole page (header included) belongs to it, and cut it into objects
+static SlabPage *slab_new_page(tinybit_ctx* ctx, int cls) {
+    PoolControl *pc = pool_control(ctx);
+    uint8_t *base = ctx->memory->lua_state;
+
+    // any block this big holds a page-aligned page plus the leftover front
+    BlockHeader *hdr = bin_search(pc, fit_index(2 * SLAB_PAGE_SIZE + MIN_BLOCK_SIZE));
+    if (!hdr) {
+        return NULL;
+    }
+    bin_remove(pc, hdr);
+
+    size_t offset = (size_t)((uint8_t *)hdr - base);
+    size_t page_offset = (offset + SLAB_PAGE_SIZE - 1) & ~(size_t)(SLAB_PAGE_SIZE - 1);
+    if (page_offset != offset && page_offset - offset < BLOCK_HDR_SIZE + MIN_BLOCK_SIZE) {
+        page_offset += SLAB_PAGE_SIZE;
+    }
+
+    BlockHeader *page_hdr = (BlockHeader *)(base + page_offset);
+    if (page_hdr != hdr) {
+        // the part in front stays free
+        page_hdr->size = hdr->size - (page_offset - offset);
+        hdr->size = page_offset - offset - BLOCK_HDR_SIZE;
+        mark_block(ctx, hdr, true);
+        bin_insert(pc, hdr);
+    }
+    split_block(ctx, page_hdr, SLAB_PAGE_SIZE - BLOCK_HDR_SIZE);
+    mark_block(ctx, page_hdr, false);
+    page_hdr->slab = true;
+
+    size_t index = page_offset / SLAB_PAGE_SIZE;
+    pc->slab_map[index / 32] |= 1u << (index % 32);
+
+    SlabPage *page = (SlabPage *)((uint8_t *)page_hdr + BLOCK_HDR_SIZE);
+    uint8_t *obj = (uint8_t *)page + ALIGN_UP(sizeof(SlabPage));
+    size_t size = slab_object_size(cls);
+    int count = slab_objects_per_page(cls);
+    page->free = NULL;
+    for (int i = count - 1; i >= 0; i--) {
+        *(void **)(obj + i * size) = page->free;
+        page->free = obj + i * size;
+    }
+    page->cls = (uint16_t)cls;
+    page->used = 0;
+
+    pc->slabs[cls].pages++;
+    slab_list_push(&pc->slabs[cls], page);
+    return page;
+}
+
+static void *slab_alloc(tinybit_ctx* ctx, size_t nsize) {
+    int cls = (int)((nsize + SLAB_STEP - 1) / SLAB_STEP) - 1;
+    SlabClass *sc = &pool_control(ctx)->slabs[cls];
+
+    SlabPage *page = sc->partial;
+    if (!page) {
+        page = slab_new_page(ctx, cls);
+        if (!page) {
+            return NULL;
         }
     }
 
-    // coalesce with previous block (scan from start)
-    uint8_t *pos = tinybit_memory->lua_state;
-    while (pos < (uint8_t *)hdr) {
-        BlockHeader *prev = (BlockHeader *)pos;
-        uint8_t *prev_end = pos + BLOCK_HDR_SIZE + prev->size;
-        if (prev_end == (uint8_t *)hdr && prev->free) {
-            prev->size += BLOCK_HDR_SIZE + hdr->size;
-            break;
+    void *obj = page->free;
+    page->free = *(void **)obj;
+    page->used++;
+    sc->used++;
+    if (!page->free) {
+        slab_list_remove(sc, page); // full
+    }
+    heap_grew(ctx, slab_object_size(cls));
+    return obj;
+}
+
+// Hand an empty page (already off the partial list) back to the block allocator
+static void slab_release_page(tinybit_ctx* ctx, SlabPage *page) {
+    PoolControl *pc = pool_control(ctx);
+    BlockHeader *hdr = (BlockHeader *)((uint8_t *)page - BLOCK_HDR_SIZE);
+    size_t index = (size_t)((uint8_t *)hdr - ctx->memory->lua_state) / SLAB_PAGE_SIZE;
+
+    pc->slabs[page->cls].pages--;
+    pc->slab_map[index / 32] &= ~(1u << (index % 32));
+    hdr->slab = false;
+    release_block(ctx, hdr);
+}
+
+// Empty pages go back to the block allocator, except a class's last one
+static void slab_free(tinybit_ctx* ctx, SlabPage *page, void *obj) {
+    SlabClass *sc = &pool_control(ctx)->slabs[page->cls];
+    bool was_full = page->free == NULL;
+
+    *(void **)obj = page->free;
+    page->free = obj;
+    page->used--;
+    sc->used--;
+    ctx->lua_heap.used -= slab_object_size(page->cls);
+
+    if (page->used == 0 && sc->pages > 1) {
+        if (!was_full) {
+            slab_list_remove(sc, page);
         }
-        pos = prev_end;
+        slab_release_page(ctx, page);
+    } else if (was_full) {
+        slab_list_push(sc, page);
     }
 }
 
-static void *l_alloc_pool(void *ud, void *ptr, size_t osize, size_t nsize) {
-    (void)ud;
+// Release the empty page each class keeps in reserve. Returns true if any
+// memory went back to the block allocator.
+static bool slab_trim(tinybit_ctx* ctx) {
+    PoolControl *pc = pool_control(ctx);
+    bool released = false;
 
-    if (!lua_heap_initialized) {
-        lua_heap_init();
+    for (int cls = 0; cls < TB_SLAB_CLASSES; cls++) {
+        SlabPage *page = pc->slabs[cls].partial;
+        while (page) {
+            SlabPage *next = page->next;
+            if (page->used == 0) {
+                slab_list_remove(&pc->slabs[cls], page);
+                slab_release_page(ctx, page);
+                released = true;
+            }
+            page = next;
+        }
     }
+    return released;
+}
 
-    if (nsize == 0) {
-        pool_free(ptr);
+// Resize a block where it is when possible: shrinking splits off the tail,
+// growing absorbs a free successor. Otherwise move it.
+static void *pool_realloc(tinybit_ctx* ctx, void *ptr, size_t nsize) {
+    BlockHeader *hdr = (BlockHeader *)((uint8_t *)ptr - BLOCK_HDR_SIZE);
+    size_t old_size = hdr->size;
+
+    if (nsize > TB_MEM_LUA_STATE_SIZE) {
         return NULL;
     }
+    size_t size = block_size(nsize);
 
-    if (ptr == NULL) {
-        return pool_alloc(nsize);
+    if (size <= hdr->size) {
+        split_block(ctx, hdr, size);
+        ctx->lua_heap.used -= old_size - hdr->size;
+        return ptr;
     }
 
-    // realloc: allocate new block, copy, free old
-    void *new_ptr = pool_alloc(nsize);
+    BlockHeader *next = next_block(ctx, hdr);
+    if (next && next->free && hdr->size + BLOCK_HDR_SIZE + next->size >= size) {
+        bin_remove(pool_control(ctx), next);
+        hdr->size += BLOCK_HDR_SIZE + next->size;
+        split_block(ctx, hdr, size);
+        mark_block(ctx, hdr, false);
+        heap_grew(ctx, hdr->size - old_size);
+        return ptr;
+    }
+
+    void *new_ptr = pool_alloc(ctx, nsize);
     if (new_ptr) {
-        memcpy(new_ptr, ptr, osize < nsize ? osize : nsize);
-        pool_free(ptr);
+        memcpy(new_ptr, ptr, old_size < nsize ? old_size : nsize);
+        pool_free(ctx, ptr);
+    }
+    return new_ptr;
+}
+
+// Small requests go to the slabs, the rest (and small ones when no slab
+// page can be had) to the block allocator
+static void *heap_alloc(tinybit_ctx* ctx, size_t nsize) {
+    if (nsize <= SLAB_MAX) {
+        void *obj = slab_alloc(ctx, nsize);
+        if (obj) {
+            return obj;
+        }
+    }
+    return pool_alloc(ctx, nsize);
+}
+
+static void heap_free(tinybit_ctx* ctx, void *ptr) {
+    SlabPage *page = slab_page_of(ctx, ptr);
+    if (page) {
+        slab_free(ctx, page, ptr);
+    } else {
+        pool_free(ctx, ptr);
     }
+}
+
+static void *heap_realloc(tinybit_ctx* ctx, void *ptr, size_t nsize) {
+    SlabPage *page = slab_page_of(ctx, ptr);
+    if (!page) {
+        return pool_realloc(ctx, ptr, nsize);
+    }
+
+    size_t size = slab_object_size(page->cls);
+    if (nsize <= size && nsize > size - SLAB_STEP) {
+        return ptr; // same class
+    }
+    void *new_ptr = heap_alloc(ctx, nsize);
+    if (!new_ptr) {
+        // Lua expects a shrinking realloc to succeed; keep the larger slot
+        return nsize < size ? ptr : NULL;
+    }
+    memcpy(new_ptr, ptr, size < nsize ? size : nsize);
+    slab_free(ctx, page, ptr);
     return new_ptr;
 }
 
-lua_State* lua_pool_newstate(void) {
-    lua_State *L = lua_newstate(l_alloc_pool, NULL);
+static int size_bucket(size_t size) {
+    int bucket = size <= 16 ? 0 : floor_log2(size - 1) - 3;
+    return bucket < TB_HEAP_BUCKETS ? bucket : TB_HEAP_BUCKETS - 1;
+}
+
+// Usage, free space layout and allocation counters. Walks the free lists,
+// so the cost grows with the number of free blocks.
+void lua_pool_stats(tinybit_ctx* ctx, struct TinyBitHeapStats* stats) {
+    PoolControl *pc = pool_control(ctx);
+
+    memset(stats, 0, sizeof(*stats));
+    stats->capacity = TB_MEM_LUA_STATE_SIZE - HEAP_START;
+    stats->used = ctx->lua_heap.used;
+    stats->peak = ctx->heap_stats.peak;
+    memcpy(stats->allocations, ctx->heap_stats.allocations, sizeof(stats->allocations));
+    stats->failed_allocations = ctx->heap_stats.failed;
+    stats->dropped_frames = ctx->heap_stats.dropped_frames;
+
+    if (!ctx->lua_heap.initialized) {
+        stats->free_bytes = stats->capacity - BLOCK_HDR_SIZE;
+        stats->largest_free = stats->free_bytes;
+        stats->free_blocks = 1;
+        return;
+    }
+
+    for (int i = 0; i < BIN_COUNT; i++) {
+        for (BlockHeader *b = pc->bins[i]; b; b = links(b)->next) {
+            stats->free_bytes += b->size;
+            stats->free_blocks++;
+            if (b->size > stats->largest_free) {
+                stats->largest_free = b->size;
+            }
+        }
+    }
+    if (stats->free_bytes > 0) {
+        stats->fragmentation = 1.0f - (float)stats->largest_free / (float)stats->free_bytes;
+    }
+}
+
+// Occupancy of each slab class
+void lua_pool_slab_stats(tinybit_ctx* ctx, struct TinyBitSlabStats stats[TB_SLAB_CLASSES]) {
+    PoolControl *pc = pool_control(ctx);
+
+    for (int cls = 0; cls < TB_SLAB_CLASSES; cls++) {
+        stats[cls].object_size = (uint32_t)slab_object_size(cls);
+        stats[cls].pages = ctx->lua_heap.initialized ? pc->slabs[cls].pages : 0;
+        stats[cls].objects_used = ctx->lua_heap.initialized ? pc->slabs[cls].used : 0;
+        stats[cls].objects_capacity = stats[cls].pages * (uint32_t)slab_objects_per_page(cls);
+    }
+}
+
+// Walk the heap and check every invariant of the block layout and bins:
+// blocks tile the arena exactly, no two free blocks are adjacent, headers,
+// footers and prev_free flags agree, used matches the allocated total, and
+// every free block is in the right bin exactly once. Logs the first
+// problem found.
+bool lua_pool_validate(tinybit_ctx* ctx) {
+    PoolControl *pc = pool_control(ctx);
+    const char *problem = NULL;
+    size_t used = 0;
+    size_t free_blocks = 0;
+    bool prev_free = false;
+
+    if (!ctx->lua_heap.initialized) {
+        return true;
+    }
+
+    uint8_t *pos = ctx->memory->lua_state + HEAP_START;
+    while (!problem && pos < heap_end(ctx)) {
+        BlockHeader *hdr = (BlockHeader *)pos;
+        if (hdr->size < MIN_BLOCK_SIZE || hdr->size != ALIGN_UP(hdr->size)
+            || hdr->size > (size_t)(heap_end(ctx) - pos) - BLOCK_HDR_SIZE) {
+            problem = "bad block size";
+        } else if (hdr->prev_free != prev_free) {
+            problem = "prev_free flag out of date";
+        } else if (hdr->free && prev_free) {
+            problem = "adjacent free blocks";
+        } else if (hdr->free && *(size_t *)(pos + BLOCK_HDR_SIZE + hdr->size - FOOTER_SIZE) != hdr->size) {
+            problem = "footer does not match header";
+        } else if (hdr->free) {
+            BlockHeader *b = pc->bins[bin_index(hdr->size)];
+            while (b && b != hdr) b = links(b)->next;
+            if (!b) problem = "free block missing from its bin";
+            free_blocks++;
+        } else if (hdr->slab) {
+            SlabPage *page = (SlabPage *)(pos + BLOCK_HDR_SIZE);
+            if ((size_t)(pos - ctx->memory->lua_state) % SLAB_PAGE_SIZE != 0
+                || hdr->size != SLAB_PAGE_SIZE - BLOCK_HDR_SIZE
+                || slab_page_of(ctx, page) != page
+                || page->cls >= TB_SLAB_CLASSES
+                || page->used > slab_objects_per_page(page->cls)) {
+                problem = "bad slab page";
+            } else {
+                used += page->used * slab_object_size(page->cls);
+            }
+        } else {
+            used += hdr->size;
+        }
+        prev_free = hdr->free;
+        pos += BLOCK_HDR_SIZE + hdr->size;
+    }
+    if (!problem && pos != heap_end(ctx)) {
+        problem = "blocks overrun the arena";
+    }
+    if (!problem && used != ctx->lua_heap.used) {
+        problem = "used counter does not match the heap";
+    }
+
+    // every bin entry is a free block of that class, linked both ways
+    for (int i = 0; i < BIN_COUNT && !problem; i++) {
+        bool listed = (pc->bitmap[i / 32] >> (i % 32)) & 1;
+        if (listed != (pc->bins[i] != NULL)) {
+            problem = "bin bitmap out of date";
+        }
+        BlockHeader *prev = NULL;
+        for (BlockHeader *b = pc->bins[i]; b && !problem; b = links(b)->next) {
+            if (!b->free || bin_index(b->size) != i || links(b)->prev != prev) {
+                problem = "corrupt bin list";
+            } else if (free_blocks-- == 0) {
+                problem = "bins hold more blocks than the heap";
+            }
+            prev = b;
+        }
+    }
+    if (!problem && free_blocks != 0) {
+        problem = "free block missing from its bin";
+    }
+
+    if (problem && ctx->log_func) {
+        ctx->log_func(ctx, "[TinyBit] Lua heap check failed: ");
+        ctx->log_func(ctx, problem);
+        ctx->log_func(ctx, "\n");
+    }
+    return problem == NULL;
+}
+
+static void *l_alloc_pool(void *ud, void *ptr, size_t osize, size_t nsize) {
+    tinybit_ctx* ctx = (tinybit_ctx*)ud;
+
+    if (!ctx->lua_heap.initialized) {
+        lua_heap_init(ctx);
+    }
+
+    void *new_ptr = NULL;
+    if (nsize == 0) {
+        if (ptr) {
+            heap_free(ctx, ptr);
+        }
+    } else if (ptr == NULL) {
+        new_ptr = heap_alloc(ctx, nsize);
+        if (!new_ptr && slab_trim(ctx)) {
+            new_ptr = heap_alloc(ctx, nsize);
+        }
+    } else {
+        new_ptr = heap_realloc(ctx, ptr, nsize);
+        if (!new_ptr && slab_trim(ctx)) {
+            new_ptr = heap_realloc(ctx, ptr, nsize);
+        }
+    }
+
+    if (nsize > 0) {
+        ctx->heap_stats.allocations[size_bucket(nsize)]++;
+        if (!new_ptr) {
+            // Lua runs an emergency collection and asks again; reported
+            // to the host at the end of the frame
+            ctx->heap_stats.failed++;
+            ctx->lua_heap.pressure = true;
+        } else if (!ptr) {
+            ctx->heap_stats.allocated += nsize; // osize is a type tag here
+        } else if (nsize > osize) {
+            ctx->heap_stats.allocated += nsize - osize;
+        }
+    }
+
+#ifdef TB_HEAP_DEBUG
+    // every allocator call re-checks the whole heap; very slow
+    lua_pool_validate(ctx);
+#endif
+    return new_ptr;
+}
+
+lua_State* lua_pool_newstate(tinybit_ctx* ctx) {
+    lua_State *L = lua_newstate(l_alloc_pool, ctx);
     if (L) {
+        // bindings find their context through the state's extra space
+        *(tinybit_ctx**)lua_getextraspace(L) = ctx;
         lua_setup(L);
+        lua_pool_apply_gc_mode(ctx, L);
+    }
+    return L;
+}
+
+void lua_pool_apply_gc_mode(tinybit_ctx* ctx, lua_State* L) {
+    switch (ctx->gc.mode) {
+    case TB_GC_GENERATIONAL:
+        lua_gc(L, LUA_GCGEN, 0, 0);
+        lua_gc(L, LUA_GCRESTART);
+        break;
+    case TB_GC_FRAME:
+        // collection only happens in lua_pool_gc_frame (or in Lua's
+        // emergency collection when an allocation fails)
+        lua_gc(L, LUA_GCINC, 100, 200, 0);
+        lua_gc(L, LUA_GCSTOP);
+        break;
+    default:
         // Tune GC for small 256KB memory pool:
         // - pause=120: (default 100) start new cycle when memory is 120% of last cycle
         // - stepmul=200: (default 100) do 2x more work per step
         lua_gc(L, LUA_GCINC, 120, 200, 0);
+        lua_gc(L, LUA_GCRESTART);
+        break;
     }
-    return L;
 }
 
-size_t lua_pool_get_used(void) {
-    return lua_heap_used;
+// TB_GC_FRAME: collect after the frame is drawn. One step sized to twice
+// what the frame allocated always runs, so collection keeps pace with
+// allocation; with a real clock, further steps then use the time left
+// until deadline_us. A finished cycle ends the work for this frame.
+void lua_pool_gc_frame(tinybit_ctx* ctx, uint64_t deadline_us) {
+    lua_State* L = ctx->L;
+    uint64_t allocated = ctx->heap_stats.allocated > ctx->gc.allocated_mark
+                       ? ctx->heap_stats.allocated - ctx->gc.allocated_mark : 0;
+    ctx->gc.allocated_mark = ctx->heap_stats.allocated;
+
+    int step_kb = (int)(allocated * GC_FRAME_STEPMUL / 1024) + 1;
+    if (lua_gc(L, LUA_GCSTEP, step_kb)) {
+        return;
+    }
+
+    bool timed = ctx->get_ticks_us_func || (ctx->get_ticks_ms_func && !ctx->virtual_clock);
+    if (!timed || ctx->deterministic) {
+        return; // collection must not depend on host timing
+    }
+    while (stats_clock_us(ctx) < deadline_us) {
+        if (lua_gc(L, LUA_GCSTEP, GC_FRAME_SLICE_KB)) {
+            break;
+        }
+    }
+}
+
+// Free what a full, non-emergency collection can: besides garbage it
+// shrinks the string table and trims slack from thread stacks, which Lua's
+// emergency collection (run inside a failing allocation) leaves alone.
+// Empty reserve slab pages go back to the block allocator too. Call it only
+// outside Lua code, e.g. after a callback failed with LUA_ERRMEM.
+void lua_pool_recover(tinybit_ctx* ctx) {
+    lua_gc(ctx->L, LUA_GCCOLLECT);
+    slab_trim(ctx);
+    ctx->gc.allocated_mark = ctx->heap_stats.allocated;
+}
+
+// String hash seed for new states (luai_makeseed in luaconf.h). States not
+// created by lua_pool_newstate have no context and fall back to the time.
+unsigned int tinybit_lua_seed(void *ud) {
+    tinybit_ctx* ctx = (tinybit_ctx*)ud;
+    if (!ctx) {
+        return (unsigned int)time(NULL);
+    }
+    return (unsigned int)(ctx->seed ^ (ctx->seed >> 32));
+}
+
+size_t lua_pool_get_used(tinybit_ctx* ctx) {
+    return ctx->lua_heap.used;
 }
 
-void lua_pool_reset(void) {
-    lua_heap_initialized = false;
-    lua_heap_used = 0;
+void lua_pool_reset(tinybit_ctx* ctx) {
+    memset(&ctx->lua_heap, 0, sizeof(ctx->lua_heap));
+    memset(&ctx->heap_stats, 0, sizeof(ctx->heap_stats));
 }
@@ -1,11 +1,20 @@
 #ifndef LUA_POOL_H
 #define LUA_POOL_H
 
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include "lua/lua.h"
+#include "tinybit.h"
 
-lua_State* lua_pool_newstate(void);
-size_t lua_pool_get_used(void);
-void lua_pool_reset(void);
+lua_State* lua_pool_newstate(tinybit_ctx* ctx);
+size_t lua_pool_get_used(tinybit_ctx* ctx);
+void lua_pool_apply_gc_mode(tinybit_ctx* ctx, lua_State* L);
+void lua_pool_gc_frame(tinybit_ctx* ctx, uint64_t deadline_us);
+void lua_pool_recover(tinybit_ctx* ctx);
+void lua_pool_reset(tinybit_ctx* ctx);
+bool lua_pool_validate(tinybit_ctx* ctx);
+void lua_pool_stats(tinybit_ctx* ctx, struct TinyBitHeapStats* stats);
+void lua_pool_slab_stats(tinybit_ctx* ctx, struct TinyBitSlabStats stats[TB_SLAB_CLASSES]);
 
 #endif
@@ -1,36 +1,50 @@
-
-#include <stdint.h>
-#include <string.h>
-#include "memory.h"
-#include "tinybit.h"
-
-struct TinyBitMemory* tinybit_memory;
-
-// Initialize TinyBit memory by clearing all sections (preserving lua_state)
-void memory_init() {
-    memset(tinybit_memory, 0, TB_MEM_SIZE);
-}
-
-// Copy memory from source to destination within TinyBit memory space
-void mem_copy(int dst, int src, int size) {
-    if (dst + size > TB_MEM_SIZE || src + size > TB_MEM_SIZE) {
-        return;
-    }
-    memcpy(&tinybit_memory[dst], &tinybit_memory[src], size);
-}
-
-// Read a byte from TinyBit memory at specified address
-uint8_t mem_peek(int dst) {
-    if (dst < 0 || dst > TB_MEM_SIZE) {
-        return 0;
-    }
-    return *(uint8_t*)&tinybit_memory[dst];
-}
-
-// Write a byte to TinyBit memory at specified address
-void mem_poke(int dst, int val){
-    if (dst < 0 || dst > TB_MEM_SIZE) {
-        return;
-    }
-    *(uint8_t*)&tinybit_memory[dst] = val & 0xff;
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "memory.h"
+#include "tinybit.h"
+#include "graphics.h"
+
+// Initialize TinyBit memory by clearing all sections (preserving lua_state)
+void memory_init(tinybit_ctx* ctx) {
+    memset(ctx->memory, 0, TB_MEM_SIZE);
+}
+
+// Keep the spritesheet classification in step with writes to [dst, dst + size)
+static void mem_written(tinybit_ctx* ctx, int dst, int size) {
+    int start = (int)offsetof(struct TinyBitMemory, spritesheet);
+    int end = start + (int)sizeof(ctx->memory->spritesheet);
+    int from = dst > start ? dst : start;
+    int to = dst + size < end ? dst + size : end;
+    if (from < to) {
+        spritesheet_changed_pixels(ctx, (from - start) / 2, (to - start + 1) / 2 - (from - start) / 2);
+    }
+}
+
+// Copy memory from source to destination within TinyBit memory space
+void mem_copy(tinybit_ctx* ctx, int dst, int src, int size) {
+    if (dst < 0 || src < 0 || size <= 0 || dst + size > (int)TB_MEM_SIZE || src + size > (int)TB_MEM_SIZE) {
+        return;
+    }
+    uint8_t* base = (uint8_t*)ctx->memory;
+    memmove(base + dst, base + src, size);
+    mem_written(ctx, dst, size);
+}
+
+// Read a byte from TinyBit memory at specified address
+uint8_t mem_peek(tinybit_ctx* ctx, int dst) {
+    if (dst < 0 || dst >= (int)TB_MEM_SIZE) {
+        return 0;
+    }
+    return ((uint8_t*)ctx->memory)[dst];
+}
+
+// Write a byte to TinyBit memory at specified address
+void mem_poke(tinybit_ctx* ctx, int dst, int val){
+    if (dst < 0 || dst >= (int)TB_MEM_SIZE) {
+        return;
+    }
+    ((uint8_t*)ctx->memory)[dst] = val & 0xff;
+    mem_written(ctx, dst, 1);
 }
\ No newline at end of file
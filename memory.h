@@ -1,13 +1,12 @@
-#ifndef MEMORY_H
-#define MEMORY_H
-
-#include <stdint.h>
-#include "tinybit.h"
-
-// Memory function declarations
-void memory_init();
-void mem_copy(int dst, int src, int size);
-uint8_t mem_peek(int);
-void mem_poke(int, int);
-extern struct TinyBitMemory* tinybit_memory;
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <stdint.h>
+#include "tinybit.h"
+
+// Memory function declarations
+void memory_init(tinybit_ctx* ctx);
+void mem_copy(tinybit_ctx* ctx, int dst, int src, int size);
+uint8_t mem_peek(tinybit_ctx* ctx, int);
+void mem_poke(tinybit_ctx* ctx, int, int);
 #endif
\ No newline at end of file
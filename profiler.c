@@ -0,0 +1,250 @@
+#include "profiler.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "lua/lua.h"
+
+// Samples are Lua call stacks, aggregated in two open-addressing tables
+// carved out of a host buffer: frame labels ("name:line") and stacks of
+// frame ids with their summed weight. Nothing touches the Lua heap, and
+// with the profiler stopped no hook is installed for it at all.
+//
+// Any count hook makes Lua 5.4 check every instruction, so instruction
+// sampling roughly halves VM speed. Timer sampling installs a one-shot
+// hook only when the host's timer fires and costs nothing in between.
+
+#define PROFILE_DEPTH   24 // frames kept per stack, nearest the sampled function
+#define LABEL_SIZE      48
+
+struct profile_frame {
+    uint32_t hash;
+    char label[LABEL_SIZE]; // empty: free slot
+};
+
+struct profile_stack {
+    uint32_t hash;
+    uint16_t depth;         // 0: free slot
+    uint16_t frames[PROFILE_DEPTH]; // outermost first
+    uint64_t weight;
+};
+
+static uint32_t fnv1a(const void* data, size_t size, uint32_t hash) {
+    const uint8_t* p = (const uint8_t*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ p[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t floor_pow2(size_t n) {
+    uint32_t p = 1;
+    while ((size_t)p * 2 <= n && p < (1u << 16)) {
+        p *= 2;
+    }
+    return n ? p : 0;
+}
+
+// Folded-stack frame name: "name:line" for Lua functions, the name for C
+// functions, "main" for the script's top level. ';' and ' ' are separators
+// in the output format, so they are replaced.
+static void frame_label(lua_Debug* ar, char* label) {
+    if (ar->what[0] == 'm') {
+        snprintf(label, LABEL_SIZE, "main");
+    } else if (ar->what[0] == 'C') {
+        snprintf(label, LABEL_SIZE, "%s", ar->name ? ar->name : "?");
+    } else {
+        snprintf(label, LABEL_SIZE, "%.36s:%d", ar->name ? ar->name : ar->short_src, ar->linedefined);
+    }
+    for (char* c = label; *c; c++) {
+        if (*c == ';' || *c == ' ') *c = '_';
+    }
+}
+
+static int frame_id(tinybit_ctx* ctx, const char* label) {
+    uint32_t hash = fnv1a(label, strlen(label), 2166136261u);
+    uint32_t mask = ctx->profile.frame_mask;
+
+    for (uint32_t i = hash & mask;; i = (i + 1) & mask) {
+        struct profile_frame* f = &ctx->profile.frames[i];
+        if (f->label[0] == '\0') {
+            if (ctx->profile.frame_count >= mask - mask / 4) {
+                return -1; // full
+            }
+            f->hash = hash;
+            memcpy(f->label, label, LABEL_SIZE);
+            ctx->profile.frame_count++;
+            return (int)i;
+        }
+        if (f->hash == hash && strcmp(f->label, label) == 0) {
+            return (int)i;
+        }
+    }
+}
+
+static bool add_stack(tinybit_ctx* ctx, const uint16_t* frames, int depth, uint64_t weight) {
+    uint32_t hash = fnv1a(frames, (size_t)depth * sizeof(frames[0]), 2166136261u);
+    uint32_t mask = ctx->profile.stack_mask;
+
+    for (uint32_t i = hash & mask;; i = (i + 1) & mask) {
+        struct profile_stack* s = &ctx->profile.stacks[i];
+        if (s->depth == 0) {
+            if (ctx->profile.stack_count >= mask - mask / 4) {
+                return false;
+            }
+            s->hash = hash;
+            s->depth = (uint16_t)depth;
+            memcpy(s->frames, frames, (size_t)depth * sizeof(frames[0]));
+            s->weight = weight;
+            ctx->profile.stack_count++;
+            return true;
+        }
+        if (s->hash == hash && s->depth == depth
+            && memcmp(s->frames, frames, (size_t)depth * sizeof(frames[0])) == 0) {
+            s->weight += weight;
+            return true;
+        }
+    }
+}
+
+static void sample(tinybit_ctx* ctx, lua_State* L, uint64_t weight) {
+    uint16_t frames[PROFILE_DEPTH];
+    char label[LABEL_SIZE];
+    lua_Debug ar;
+    int depth = 0;
+
+    // level 0 is the running function; walk outwards
+    while (depth < PROFILE_DEPTH && lua_getstack(L, depth, &ar)) {
+        lua_getinfo(L, "Sn", &ar);
+        frame_label(&ar, label);
+        int id = frame_id(ctx, label);
+        if (id < 0) {
+            ctx->profile.dropped++;
+            return;
+        }
+        frames[PROFILE_DEPTH - 1 - depth] = (uint16_t)id;
+        depth++;
+    }
+    if (depth == 0) {
+        return;
+    }
+    if (add_stack(ctx, frames + PROFILE_DEPTH - depth, depth, weight)) {
+        ctx->profile.samples++;
+    } else {
+        ctx->profile.dropped++;
+    }
+}
+
+// Lay out the frame and stack tables in buffer and start sampling. interval
+// is in VM instructions (TB_PROFILE_INSTRUCTIONS) or the host timer's
+// period in microseconds (TB_PROFILE_TIME). Earlier results are discarded.
+bool profiler_start(tinybit_ctx* ctx, void* buffer, size_t size, enum TinyBitProfileMode mode, uint32_t interval) {
+    memset(&ctx->profile, 0, sizeof(ctx->profile));
+    if (!buffer || interval == 0) {
+        return false;
+    }
+
+    uintptr_t start = ((uintptr_t)buffer + 7) & ~(uintptr_t)7;
+    size_t skip = (size_t)(start - (uintptr_t)buffer);
+    if (size < skip) {
+        return false;
+    }
+    size -= skip;
+
+    // about a quarter of the space for frame labels, the rest for stacks
+    uint32_t frames = floor_pow2(size / 4 / sizeof(struct profile_frame));
+    size_t frame_bytes = frames * sizeof(struct profile_frame);
+    uint32_t stacks = floor_pow2((size - frame_bytes) / sizeof(struct profile_stack));
+    if (frames < 16 || stacks < 16) {
+        return false;
+    }
+
+    ctx->profile.frames = (struct profile_frame*)start;
+    ctx->profile.stacks = (struct profile_stack*)(start + frame_bytes);
+    memset(ctx->profile.frames, 0, frame_bytes);
+    memset(ctx->profile.stacks, 0, stacks * sizeof(struct profile_stack));
+    ctx->profile.frame_mask = frames - 1;
+    ctx->profile.stack_mask = stacks - 1;
+    ctx->profile.mode = mode;
+    ctx->profile.interval = interval;
+    ctx->profile.countdown = interval;
+    ctx->profile.active = true;
+    return true;
+}
+
+// Stop sampling; the tables stay in the buffer for profiler_dump()
+void profiler_stop(tinybit_ctx* ctx) {
+    ctx->profile.active = false;
+}
+
+// True if the profiler samples from the count hook (instruction mode)
+bool profiler_counting(tinybit_ctx* ctx) {
+    return ctx->profile.active && ctx->profile.mode == TB_PROFILE_INSTRUCTIONS;
+}
+
+// Called from the count hook every instructions VM instructions
+void profiler_tick(tinybit_ctx* ctx, lua_State* L, uint32_t instructions) {
+    ctx->profile.countdown -= instructions;
+    if (ctx->profile.countdown <= 0) {
+        sample(ctx, L, ctx->profile.interval);
+        ctx->profile.countdown += ctx->profile.interval;
+    }
+}
+
+// Host timer tick in TB_PROFILE_TIME: ask for a sample at the next
+// instruction of the running Lua code, if any. Uses only lua_sethook, which
+// Lua allows from a signal handler or another thread.
+void profiler_request_sample(tinybit_ctx* ctx, lua_Hook hook) {
+    lua_State* L = ctx->profile.thread;
+    if (!ctx->profile.active || ctx->profile.mode != TB_PROFILE_TIME || !L) {
+        return;
+    }
+    ctx->profile.sample_pending = true;
+    lua_sethook(L, hook, LUA_MASKCOUNT, 1);
+}
+
+// The requested sample, taken from inside the hook
+void profiler_take_sample(tinybit_ctx* ctx, lua_State* L) {
+    ctx->profile.sample_pending = false;
+    if (ctx->profile.active) {
+        sample(ctx, L, ctx->profile.interval);
+    }
+}
+
+// Write the stacks as folded lines ("main;update:12;move:40 1234\n") into
+// out, or through the log callback when out is NULL. Only whole lines are
+// written and out is NUL-terminated; returns the size of the full output.
+size_t profiler_dump(tinybit_ctx* ctx, char* out, size_t capacity) {
+    char line[PROFILE_DEPTH * LABEL_SIZE + 24];
+    size_t total = 0;
+    size_t written = 0;
+
+    for (uint32_t i = 0; ctx->profile.stacks && i <= ctx->profile.stack_mask; i++) {
+        const struct profile_stack* s = &ctx->profile.stacks[i];
+        if (s->depth == 0) {
+            continue;
+        }
+
+        size_t len = 0;
+        for (int d = 0; d < s->depth; d++) {
+            len += (size_t)snprintf(line + len, sizeof(line) - len, "%s%s", d ? ";" : "",
+                                    ctx->profile.frames[s->frames[d]].label);
+        }
+        len += (size_t)snprintf(line + len, sizeof(line) - len, " %" PRIu64 "\n", s->weight);
+
+        if (!out) {
+            if (ctx->log_func) {
+                ctx->log_func(ctx, line);
+            }
+        } else if (written == total && written + len < capacity) {
+            memcpy(out + written, line, len);
+            written += len;
+        }
+        total += len;
+    }
+    if (out && capacity > 0) {
+        out[written] = '\0';
+    }
+    return total;
+}
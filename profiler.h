@@ -0,0 +1,18 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "lua/lua.h"
+#include "tinybit.h"
+
+bool profiler_start(tinybit_ctx* ctx, void* buffer, size_t size, enum TinyBitProfileMode mode, uint32_t interval);
+void profiler_stop(tinybit_ctx* ctx);
+bool profiler_counting(tinybit_ctx* ctx);
+void profiler_tick(tinybit_ctx* ctx, struct lua_State* L, uint32_t instructions);
+void profiler_request_sample(tinybit_ctx* ctx, lua_Hook hook);
+void profiler_take_sample(tinybit_ctx* ctx, struct lua_State* L);
+size_t profiler_dump(tinybit_ctx* ctx, char* out, size_t capacity);
+
+#endif
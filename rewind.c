@@ -0,0 +1,272 @@
+#include "rewind.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "tinybit.h"
+#include "snapshot.h"
+
+// The host buffer holds the newest machine state in full (the reference)
+// followed by a ring of backward deltas, one per captured frame:
+//
+//   [u32 length][payload][u32 length]
+//
+// A payload is the XOR of a frame's state with the following frame's,
+// coded as (zero run, literal count, literal bytes) tokens with LEB128
+// counts. XOR-ing the newest payload into the reference steps it one frame
+// back. When the ring is full the oldest frames are dropped.
+
+#define RECORD_OVERHEAD 8
+#define MIN_ZERO_RUN    4  // shorter zero runs stay inside a literal
+#define SCAN_CHUNK      64
+#define MAX_SPANS       16 // TinyBitMemory plus the snapshot fields
+
+struct span {
+    uint8_t* ref;
+    const uint8_t* live;
+    size_t size;
+};
+
+static void ring_put(tinybit_ctx* ctx, uint8_t byte) {
+    ctx->rewind.ring[ctx->rewind.head] = byte;
+    if (++ctx->rewind.head == ctx->rewind.capacity) {
+        ctx->rewind.head = 0;
+    }
+}
+
+static uint8_t ring_get(tinybit_ctx* ctx, size_t* pos) {
+    uint8_t byte = ctx->rewind.ring[*pos];
+    if (++*pos == ctx->rewind.capacity) {
+        *pos = 0;
+    }
+    return byte;
+}
+
+static void ring_put_u32(tinybit_ctx* ctx, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        ring_put(ctx, (uint8_t)(value >> (i * 8)));
+    }
+}
+
+static uint32_t ring_get_u32(tinybit_ctx* ctx, size_t pos) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+        value |= (uint32_t)ring_get(ctx, &pos) << (i * 8);
+    }
+    return value;
+}
+
+static size_t ring_back(tinybit_ctx* ctx, size_t pos, size_t n) {
+    return (pos + ctx->rewind.capacity - n) % ctx->rewind.capacity;
+}
+
+static size_t varint_size(size_t value) {
+    size_t n = 1;
+    while (value > 0x7F) {
+        value >>= 7;
+        n++;
+    }
+    return n;
+}
+
+static void put_varint(tinybit_ctx* ctx, size_t value) {
+    while (value > 0x7F) {
+        ring_put(ctx, (uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    ring_put(ctx, (uint8_t)value);
+}
+
+static size_t get_varint(tinybit_ctx* ctx, size_t* pos, size_t* remaining) {
+    size_t value = 0;
+    int shift = 0;
+    while (*remaining > 0) {
+        uint8_t byte = ring_get(ctx, pos);
+        (*remaining)--;
+        value |= (size_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) break;
+        shift += 7;
+    }
+    return value;
+}
+
+// Reference state vs live state: TinyBitMemory, then the machine fields
+static int build_spans(tinybit_ctx* ctx, struct span* spans) {
+    struct TinyBitSnapshot* ref = ctx->rewind.ref;
+    spans[0].ref = (uint8_t*)&ref->memory;
+    spans[0].live = (const uint8_t*)ctx->memory;
+    spans[0].size = sizeof(ref->memory);
+    for (int i = 0; i < snapshot_field_count; i++) {
+        spans[i + 1].ref = (uint8_t*)&ref->state + snapshot_fields[i].offset;
+        spans[i + 1].live = (const uint8_t*)ctx + snapshot_fields[i].offset;
+        spans[i + 1].size = snapshot_fields[i].size;
+    }
+    return snapshot_field_count + 1;
+}
+
+// Code the delta between reference and live state. With write set the
+// tokens go to the ring and the reference is brought up to date; otherwise
+// only the payload size is computed.
+static size_t encode_delta(tinybit_ctx* ctx, struct span* spans, int count, bool write) {
+    size_t out = 0;
+    size_t zeros = 0;
+
+    for (int s = 0; s < count; s++) {
+        uint8_t* ref = spans[s].ref;
+        const uint8_t* live = spans[s].live;
+        size_t size = spans[s].size;
+        size_t pos = 0;
+
+        while (pos < size) {
+            // unchanged bytes, whole chunks at a time where possible
+            while (pos + SCAN_CHUNK <= size && memcmp(ref + pos, live + pos, SCAN_CHUNK) == 0) {
+                pos += SCAN_CHUNK;
+                zeros += SCAN_CHUNK;
+            }
+            while (pos < size && ref[pos] == live[pos]) {
+                pos++;
+                zeros++;
+            }
+            if (pos == size) break;
+
+            // changed bytes, up to the next long enough unchanged run
+            size_t end = pos;
+            size_t last = pos;
+            while (end < size && end - last <= MIN_ZERO_RUN) {
+                if (ref[end] != live[end]) last = end;
+                end++;
+            }
+            size_t literal = last + 1 - pos;
+
+            out += varint_size(zeros) + varint_size(literal) + literal;
+            if (write) {
+                put_varint(ctx, zeros);
+                put_varint(ctx, literal);
+                for (size_t i = pos; i < pos + literal; i++) {
+                    ring_put(ctx, ref[i] ^ live[i]);
+                }
+                memcpy(ref + pos, live + pos, literal);
+            }
+            zeros = 0;
+            pos += literal;
+        }
+    }
+    return out;
+}
+
+// XOR one payload into the reference, stepping it a frame back
+static void apply_delta(tinybit_ctx* ctx, struct span* spans, int count, size_t pos, size_t length) {
+    int s = 0;
+    size_t offset = 0;
+
+    while (length > 0) {
+        size_t zeros = get_varint(ctx, &pos, &length);
+        size_t literal = get_varint(ctx, &pos, &length);
+
+        while (s < count && offset + zeros >= spans[s].size) {
+            zeros -= spans[s].size - offset;
+            offset = 0;
+            s++;
+        }
+        offset += zeros;
+        if (s == count || literal > length || offset + literal > spans[s].size) {
+            return; // corrupt record
+        }
+        for (size_t i = 0; i < literal; i++) {
+            spans[s].ref[offset + i] ^= ring_get(ctx, &pos);
+        }
+        offset += literal;
+        length -= literal;
+    }
+}
+
+static void drop_oldest(tinybit_ctx* ctx) {
+    uint32_t length = ring_get_u32(ctx, ctx->rewind.tail);
+    ctx->rewind.tail = (ctx->rewind.tail + length + RECORD_OVERHEAD) % ctx->rewind.capacity;
+    ctx->rewind.used -= length + RECORD_OVERHEAD;
+    ctx->rewind.frames--;
+}
+
+static void drop_all(tinybit_ctx* ctx) {
+    ctx->rewind.head = 0;
+    ctx->rewind.tail = 0;
+    ctx->rewind.used = 0;
+    ctx->rewind.frames = 0;
+}
+
+// Carve the reference state and the ring out of the host buffer
+bool rewind_init(tinybit_ctx* ctx, void* buffer, size_t size) {
+    memset(&ctx->rewind, 0, sizeof(ctx->rewind));
+    if (!buffer) {
+        return true; // rewind off
+    }
+
+    uintptr_t start = ((uintptr_t)buffer + 15) & ~(uintptr_t)15;
+    size_t skip = (size_t)(start - (uintptr_t)buffer) + sizeof(struct TinyBitSnapshot);
+    if (size < skip + RECORD_OVERHEAD + 64) {
+        return false;
+    }
+
+    ctx->rewind.ref = (struct TinyBitSnapshot*)start;
+    ctx->rewind.ref->valid = false;
+    ctx->rewind.ring = (uint8_t*)buffer + skip;
+    ctx->rewind.capacity = size - skip;
+    return true;
+}
+
+// Record the state at the end of a frame
+void rewind_capture(tinybit_ctx* ctx) {
+    struct span spans[MAX_SPANS];
+    struct TinyBitSnapshot* ref = ctx->rewind.ref;
+
+    if (!ref->valid || ref->owner != ctx || ref->owner_memory != ctx->memory) {
+        snapshot_capture(ctx, ref); // first frame, or the memory block moved
+        drop_all(ctx);
+        return;
+    }
+
+    int count = build_spans(ctx, spans);
+    size_t length = encode_delta(ctx, spans, count, false);
+    size_t needed = length + RECORD_OVERHEAD;
+
+    if (needed > ctx->rewind.capacity || length > UINT32_MAX) {
+        // a jump too large to keep: the history ends here
+        snapshot_capture(ctx, ref);
+        drop_all(ctx);
+        return;
+    }
+    while (ctx->rewind.used + needed > ctx->rewind.capacity) {
+        drop_oldest(ctx);
+    }
+
+    ring_put_u32(ctx, (uint32_t)length);
+    encode_delta(ctx, spans, count, true);
+    ring_put_u32(ctx, (uint32_t)length);
+    ctx->rewind.used += needed;
+    ctx->rewind.frames++;
+}
+
+// Step the machine back up to frames captured frames; returns how many
+int rewind_frames(tinybit_ctx* ctx, int frames) {
+    struct span spans[MAX_SPANS];
+    struct TinyBitSnapshot* ref = ctx->rewind.ref;
+    int count = build_spans(ctx, spans);
+    int done = 0;
+
+    if (!ref->valid) {
+        return 0;
+    }
+
+    while (done < frames && ctx->rewind.frames > 0) {
+        uint32_t length = ring_get_u32(ctx, ring_back(ctx, ctx->rewind.head, 4));
+        size_t start = ring_back(ctx, ctx->rewind.head, length + RECORD_OVERHEAD);
+        apply_delta(ctx, spans, count, (start + 4) % ctx->rewind.capacity, length);
+        ctx->rewind.head = start;
+        ctx->rewind.used -= length + RECORD_OVERHEAD;
+        ctx->rewind.frames--;
+        done++;
+    }
+
+    snapshot_restore(ctx, ref);
+    return done;
+}
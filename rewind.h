@@ -0,0 +1,12 @@
+#ifndef REWIND_H
+#define REWIND_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "tinybit.h"
+
+bool rewind_init(tinybit_ctx* ctx, void* buffer, size_t size);
+void rewind_capture(tinybit_ctx* ctx);
+int rewind_frames(tinybit_ctx* ctx, int frames);
+
+#endif
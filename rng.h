@@ -0,0 +1,49 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+// xoshiro128** - small, fast PRNG using only 32-bit operations, so it is
+// cheap on the ESP32 as well as on desktop.
+
+static inline uint32_t rng_rotl(uint32_t x, int k) {
+    return (x << k) | (x >> (32 - k));
+}
+
+// Seed the 128-bit state from a 64-bit seed with splitmix64
+static inline void rng_seed(uint32_t state[4], uint64_t seed) {
+    for (int i = 0; i < 4; i++) {
+        uint64_t z = (seed += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        state[i] = (uint32_t)((z ^ (z >> 31)) >> 32);
+    }
+}
+
+static inline uint32_t rng_next(uint32_t state[4]) {
+    uint32_t result = rng_rotl(state[1] * 5, 7) * 9;
+    uint32_t t = state[1] << 9;
+
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = rng_rotl(state[3], 11);
+
+    return result;
+}
+
+// Uniform integer in [min, max]
+static inline int rng_range(uint32_t state[4], int min, int max) {
+    if (max <= min) return min;
+    uint32_t span = (uint32_t)(max - min) + 1;
+    return min + (int)(((uint64_t)rng_next(state) * span) >> 32);
+}
+
+// Uniform float in [-1, 1)
+static inline float rng_signed_unit(uint32_t state[4]) {
+    return (float)(int32_t)rng_next(state) * (1.0f / 2147483648.0f);
+}
+
+#endif
@@ -0,0 +1,71 @@
+#include "snapshot.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "tinybit.h"
+#include "cartridge.h"
+
+#define MACHINE_FIELD(f) { offsetof(tinybit_ctx, f), sizeof(((tinybit_ctx*)0)->f) }
+
+// The context fields that belong to the running machine. Host settings
+// (callbacks, seed, recording) and host-facing counters (stats, heap_stats)
+// stay put.
+const struct snapshot_field snapshot_fields[] = {
+    MACHINE_FIELD(L),
+    MACHINE_FIELD(sleep_ms),
+    MACHINE_FIELD(sleep_start_time),
+    MACHINE_FIELD(frame_time),
+    MACHINE_FIELD(virtual_frames),
+    MACHINE_FIELD(rng),
+    MACHINE_FIELD(noise_rng),
+    MACHINE_FIELD(update),
+    MACHINE_FIELD(lua_heap),
+    MACHINE_FIELD(graphics),
+    MACHINE_FIELD(font),
+    MACHINE_FIELD(prev_button_state),
+    MACHINE_FIELD(update_button_state),
+    MACHINE_FIELD(channels),
+    MACHINE_FIELD(cartridge),
+};
+
+const int snapshot_field_count = sizeof(snapshot_fields) / sizeof(snapshot_fields[0]);
+
+static void copy_machine_state(tinybit_ctx* dst, const tinybit_ctx* src) {
+    for (int i = 0; i < snapshot_field_count; i++) {
+        size_t offset = snapshot_fields[i].offset;
+        memcpy((uint8_t*)dst + offset, (const uint8_t*)src + offset, snapshot_fields[i].size);
+    }
+}
+
+// Everything the Lua state, audio channels and PNG decoder point at lives in
+// TinyBitMemory, so memory plus the fields above is the whole machine
+void snapshot_capture(tinybit_ctx* ctx, struct TinyBitSnapshot* snap) {
+    memcpy(&snap->memory, ctx->memory, sizeof(snap->memory));
+    snap->owner = ctx;
+    snap->owner_memory = ctx->memory;
+    copy_machine_state(&snap->state, ctx);
+    snap->valid = true;
+}
+
+// The captured pointers are absolute, so a snapshot only restores into the
+// context and memory block it was taken from
+bool snapshot_restore(tinybit_ctx* ctx, const struct TinyBitSnapshot* snap) {
+    if (!snap->valid || snap->owner != ctx || snap->owner_memory != ctx->memory) {
+        return false;
+    }
+    memcpy(ctx->memory, &snap->memory, sizeof(snap->memory));
+    copy_machine_state(ctx, &snap->state);
+    return true;
+}
+
+// True if snap was taken while the current script was loaded
+bool snapshot_matches_script(tinybit_ctx* ctx, const struct TinyBitSnapshot* snap) {
+    if (!snap->valid) {
+        return false;
+    }
+    bool bytecode;
+    size_t len = cartridge_script(ctx, &bytecode);
+    return memcmp(snap->memory.script, ctx->memory->script, len + 1) == 0;
+}
@@ -0,0 +1,21 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "tinybit.h"
+
+// A range of tinybit_ctx bytes that belongs to the machine state
+struct snapshot_field {
+    size_t offset;
+    size_t size;
+};
+
+extern const struct snapshot_field snapshot_fields[];
+extern const int snapshot_field_count;
+
+void snapshot_capture(tinybit_ctx* ctx, struct TinyBitSnapshot* snap);
+bool snapshot_restore(tinybit_ctx* ctx, const struct TinyBitSnapshot* snap);
+bool snapshot_matches_script(tinybit_ctx* ctx, const struct TinyBitSnapshot* snap);
+
+#endif
@@ -0,0 +1,91 @@
+#include "stats.h"
+
+#include <string.h>
+
+#include "tinybit.h"
+#include "lua_pool.h"
+
+#define FRAME_BUDGET_US (1000000 / TB_FRAME_RATE)
+// the millisecond clock reads a 16.67 ms frame as 16 or 17 ms
+#define FRAME_BUDGET_MS_US ((1000 / TB_FRAME_RATE + 1) * 1000)
+
+void stats_reset(tinybit_ctx* ctx) {
+    memset(&ctx->stats, 0, sizeof(ctx->stats));
+}
+
+// Microsecond timestamp for phase timing. Uses the host's microsecond clock
+// when set, otherwise the millisecond clock (not read while stepping).
+uint64_t stats_clock_us(tinybit_ctx* ctx) {
+    if (ctx->get_ticks_us_func) {
+        return ctx->get_ticks_us_func(ctx);
+    }
+    if (ctx->virtual_clock || !ctx->get_ticks_ms_func) {
+        return 0;
+    }
+    return (uint64_t)ctx->get_ticks_ms_func(ctx) * 1000;
+}
+
+// Time since *since in microseconds; moves *since to now
+uint32_t stats_lap_us(tinybit_ctx* ctx, uint64_t* since) {
+    uint64_t now = stats_clock_us(ctx);
+    uint32_t elapsed = now > *since ? (uint32_t)(now - *since) : 0;
+    *since = now;
+    return elapsed;
+}
+
+// Store one frame's phase timings in the rolling window
+void stats_record_frame(tinybit_ctx* ctx, const uint32_t phase_us[TB_PHASE_COUNT]) {
+    uint32_t slot = (uint32_t)(ctx->stats.frames % TB_STATS_WINDOW);
+
+    for (int p = 0; p < TB_PHASE_COUNT; p++) {
+        ctx->stats.last_us[p] = phase_us[p];
+        ctx->stats.history[p][slot] = phase_us[p];
+    }
+    uint32_t budget_us = ctx->get_ticks_us_func ? FRAME_BUDGET_US : FRAME_BUDGET_MS_US;
+    if (phase_us[TB_PHASE_FRAME] > budget_us) {
+        ctx->stats.overruns++;
+    }
+    ctx->stats.frames++;
+}
+
+// Nearest-rank percentile of an ascending array
+static uint32_t percentile(const uint32_t* sorted, uint32_t n, uint32_t pct) {
+    uint32_t rank = (pct * n + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+void stats_get(tinybit_ctx* ctx, struct TinyBitFrameStats* out) {
+    uint32_t n = ctx->stats.frames < TB_STATS_WINDOW ? (uint32_t)ctx->stats.frames : TB_STATS_WINDOW;
+
+    memset(out, 0, sizeof(*out));
+    out->frames = ctx->stats.frames;
+    out->budget_overruns = ctx->stats.overruns;
+    out->watchdog_trips = ctx->stats.watchdog_trips;
+    out->skipped_draws = ctx->stats.skipped_draws;
+    out->suspended_draws = ctx->stats.suspended_draws;
+    out->window = n;
+    out->lua_heap_used = lua_pool_get_used(ctx);
+    out->lua_heap_peak = ctx->heap_stats.peak;
+
+    for (int p = 0; p < TB_PHASE_COUNT; p++) {
+        out->last_us[p] = ctx->stats.last_us[p];
+        if (n == 0) continue;
+
+        // insertion sort of the window; it is small and only sorted on query
+        uint32_t sorted[TB_STATS_WINDOW];
+        for (uint32_t i = 0; i < n; i++) {
+            uint32_t v = ctx->stats.history[p][i];
+            uint32_t j = i;
+            while (j > 0 && sorted[j - 1] > v) {
+                sorted[j] = sorted[j - 1];
+                j--;
+            }
+            sorted[j] = v;
+        }
+
+        out->percentiles[p].p50_us = percentile(sorted, n, 50);
+        out->percentiles[p].p95_us = percentile(sorted, n, 95);
+        out->percentiles[p].p99_us = percentile(sorted, n, 99);
+        out->percentiles[p].max_us = sorted[n - 1];
+    }
+}
@@ -0,0 +1,13 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+#include "tinybit.h"
+
+void stats_reset(tinybit_ctx* ctx);
+uint64_t stats_clock_us(tinybit_ctx* ctx);
+uint32_t stats_lap_us(tinybit_ctx* ctx, uint64_t* since);
+void stats_record_frame(tinybit_ctx* ctx, const uint32_t phase_us[TB_PHASE_COUNT]);
+void stats_get(tinybit_ctx* ctx, struct TinyBitFrameStats* out);
+
+#endif
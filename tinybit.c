@@ -1,297 +1,789 @@
-#include "tinybit.h"
-
-#include <inttypes.h>
-#include <stdbool.h>
-#include <string.h>
-#include <stdlib.h>
-#include <time.h>
-
-#include "lua_functions.h"
-#include "lua_pool.h"
-#include "cartridge.h"
-#include "graphics.h"
-#include "memory.h"
-#include "audio.h"
-#include "input.h"
-#include "font.h"
-#include "lua_scripts.h"
-
-#include "lua/lua.h"
-#include "lua/lualib.h"
-#include "lua/lauxlib.h"
-
-static bool running = true;
-static int sleep_ms = 0;
-static int sleep_start_time = 0;
-long max_memory_usage = 0;
-
-static lua_State* L;
-static void (*error_func)(const char* message, const char* traceback) = NULL;
-
-static void (*frame_func)();
-static void (*input_func)();
-static int (*get_ticks_ms_func)();
-static void (*audio_queue_func)();
-
-// Lua message handler used as the msgh arg of the runtime lua_pcall.
-// Receives the original error on the stack, returns a string that is
-// "<original>\nstack traceback:\n<frames…>".
-static int err_msgh(lua_State* l) {
-    const char* msg = lua_tostring(l, 1);
-    if (!msg) msg = "(non-string error)";
-    luaL_traceback(l, l, msg, 1);
-    return 1;
-}
-
-// Pops the error from the top of the Lua stack and, if error_func is set,
-// invokes it. For runtime errors (with_trace != 0), splits the combined
-// "msg\nstack traceback:\nframes" string from err_msgh into two parts.
-static void emit_lua_error(lua_State* l, int with_trace) {
-    const char* raw = lua_tostring(l, -1);
-    if (!raw) raw = "(non-string error)";
-
-    if (error_func) {
-        if (with_trace) {
-            const char* sep = strstr(raw, "\nstack traceback:");
-            if (sep) {
-                size_t msg_len = (size_t)(sep - raw);
-                static char msg_buf[4096];
-                if (msg_len >= sizeof(msg_buf)) msg_len = sizeof(msg_buf) - 1;
-                memcpy(msg_buf, raw, msg_len);
-                msg_buf[msg_len] = '\0';
-                const char* trace = sep + 1; // skip leading newline
-                error_func(msg_buf, trace);
-            } else {
-                error_func(raw, NULL);
-            }
-        } else {
-            error_func(raw, NULL);
-        }
-    }
-
-    lua_pop(l, 1);
-}
-
-// Initialize the TinyBit system with memory, input state, and audio buffer pointers
-void tinybit_init(struct TinyBitMemory* memory) {
-    if (!memory) {
-        return; // Error: null pointer
-    }
-
-    tinybit_memory = memory;
-
-    // initialize memory
-    srand(time(NULL));
-    memory_init();
-    lua_pool_reset();
-    tb_audio_init();
-    cartridge_init();
-    graphics_init();
-    font_init();
-
-    // reset frame loop state so a re-init mid-session starts from a clean slate
-    running = true;
-    sleep_ms = 0;
-    sleep_start_time = 0;
-
-    // set up lua VM
-    L = lua_pool_newstate();
-
-    // add special functions to lua for reading game files
-    cartridge_register_lua(L);
-
-    // initialize the game loader as the default "game"
-    memcpy(tinybit_memory->script, launcher, strlen(launcher) + 1); // copy script to memory
-}
-
-// Start executing the Lua script currently loaded in memory
-bool tinybit_start(){
-    const char* script = (const char*)tinybit_memory->script;
-    size_t script_len = strlen(script);
-
-    if (luaL_loadbuffer(L, script, script_len, "=script") != LUA_OK) {
-        // Compile error — no Lua stack yet, so no traceback.
-        emit_lua_error(L, /*with_trace=*/0);
-        return false;
-    }
-
-    // Load succeeded — install the message handler below the loaded chunk so
-    // a top-level runtime error in the script gets a traceback.
-    int msgh_idx = lua_gettop(L);     // index of the loaded chunk
-    lua_pushcfunction(L, err_msgh);   // [..., chunk, err_msgh]
-    lua_insert(L, msgh_idx);          // [..., err_msgh, chunk]
-
-    if (lua_pcall(L, 0, 0, msgh_idx) != LUA_OK) {
-        emit_lua_error(L, /*with_trace=*/1);
-        lua_remove(L, msgh_idx);
-        return false;
-    }
-    lua_remove(L, msgh_idx);
-    return true;
-}
-
-// Reset the Lua state and start a new game
-bool tinybit_restart(){
-    lua_close(L);
-    L = lua_pool_newstate();
-    draw_cls();
-    return tinybit_start();
-}
-
-// Signal the emulation loop to quit
-void tinybit_stop() {
-    running = false;
-
-    lua_close(L);
-    L = NULL;
-
-    cartridge_destroy();
-}
-
-void tinybit_sleep(int ms) {
-    sleep_ms = ms;
-    sleep_start_time = get_ticks_ms_func();
-}
-
-// Current Lua heap usage in bytes; capacity is TB_MEM_LUA_STATE_SIZE.
-size_t tinybit_lua_memory_used() {
-    return lua_pool_get_used();
-}
-
-// Feed cartridge PNG data to the TinyBit decoder
-bool tinybit_feed_cartridge(const uint8_t* buffer, size_t size){
-    return cartridge_feed(buffer, size);
-}
-
-// Main emulation loop - handles input, executes Lua draw function, and renders frames
-void tinybit_loop() {
-
-    uint32_t start_time;
-    uint32_t render_time;
-    uint32_t input_time;
-    uint32_t display_time;
-    uint32_t audio_time;
-
-    frame_time = get_ticks_ms_func();
-    start_time = frame_time;
-
-    // INPUT
-    input_func();
-    input_time = get_ticks_ms_func() - start_time;
-    start_time += input_time;
-
-    // LOGIC
-    if(sleep_ms == 0 || get_ticks_ms_func() - sleep_start_time >= sleep_ms) {
-        sleep_ms = 0;
-        lua_pushcfunction(L, err_msgh);
-        int msgh_idx = lua_gettop(L);
-        lua_getglobal(L, "_draw");
-        int status = lua_pcall(L, 0, 1, msgh_idx);
-        if (status == LUA_OK) {
-            lua_pop(L, 1);          // pop the (unused) result
-            lua_remove(L, msgh_idx); // pop the message handler
-        } else {
-            emit_lua_error(L, /*with_trace=*/1); // pops the error (with traceback)
-            lua_remove(L, msgh_idx);             // pop the message handler
-            audio_stop_all();
-            // error_screen is a hand-written clean script; tinybit_restart()
-            // will tinybit_start() it and the new path will not re-fire emit_lua_error.
-            strcpy((char*)tinybit_memory->script, error_screen);
-            tinybit_restart();
-        }
-    }
-
-    // deferred game load
-    if (cartridge_load_pending()) {
-        return;
-    }
-
-    render_time = get_ticks_ms_func() - start_time;
-    start_time += render_time;
-
-    // save current button state
-    save_button_state();
-
-    // AUDIO
-    process_audio();
-    if (audio_queue_func) {
-        audio_queue_func();
-    }
-    audio_time = get_ticks_ms_func() - start_time;
-    start_time += audio_time;
-
-    // RENDER
-    if (frame_func) {
-        frame_func();
-    }
-    display_time = get_ticks_ms_func() - start_time;
-    start_time += display_time;
-
-    // size_t used_memory = lua_pool_get_used();
-    // if (used_memory > max_memory_usage) {
-    //     max_memory_usage = used_memory;
-    //     printf("[TinyBit] New max memory usage: %zu bytes\n", max_memory_usage);
-    // }
-    // printf("[TinyBit] Frame time: %d ms (render: %d ms, display: %d ms, audio: %d ms)\n", get_ticks_ms_func() - frame_time, render_time, display_time, audio_time);
-}
-
-// Set callback function that gets called when a new frame should be drawn
-void tinybit_render_cb(void (*render_func_ptr)()) {
-    if (!render_func_ptr) {
-        return; // Error: null pointer
-    }
-
-    frame_func = render_func_ptr;
-}
-
-// Set callback function that gets called to read button state
-void tinybit_poll_input_cb(void (*poll_input_func_ptr)()) {
-    if (!poll_input_func_ptr) {
-        return; // Error: null pointer
-    }
-
-    input_func = poll_input_func_ptr;
-}
-
-void tinybit_log_cb(void (*log_func_ptr)(const char*)){
-    if (!log_func_ptr) {
-        return; // Error: null pointer
-    }
-
-    log_func = log_func_ptr;
-}
-
-void tinybit_error_cb(void (*error_func_ptr)(const char* message, const char* traceback)) {
-    error_func = error_func_ptr;
-}
-
-void tinybit_get_ticks_ms_cb(int (*get_ticks_ms_func_ptr)()) {
-    if (!get_ticks_ms_func_ptr) {
-        return; // Error: null pointer
-    }
-
-    get_ticks_ms_func = get_ticks_ms_func_ptr;
-}
-
-// Set callback function for queuing audio each frame
-void tinybit_audio_queue_cb(void (*audio_queue_func_ptr)()) {
-    if (!audio_queue_func_ptr) {
-        return; // Error: null pointer
-    }
-
-    audio_queue_func = audio_queue_func_ptr;
-}
-
-void tinybit_gamecount_cb(int (*gamecount_func_ptr)()) {
-    if (!gamecount_func_ptr) {
-        return;
-    }
-    gamecount_func = gamecount_func_ptr;
-}
-
-void tinybit_gameload_cb(void (*gameload_func_ptr)(int index)) {
-    if (!gameload_func_ptr) {
-        return;
-    }
-    gameload_func = gameload_func_ptr;
-}
+#include "tinybit.h"
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "lua_functions.h"
+#include "lua_pool.h"
+#include "cartridge.h"
+#include "graphics.h"
+#include "memory.h"
+#include "audio.h"
+#include "input.h"
+#include "font.h"
+#include "stats.h"
+#include "snapshot.h"
+#include "rewind.h"
+#include "watchdog.h"
+#include "chunk_cache.h"
+#include "profiler.h"
+#include "rng.h"
+#include "lua_scripts.h"
+
+#include "lua/lua.h"
+#include "lua/lualib.h"
+#include "lua/lauxlib.h"
+
+// Lua message handler used as the msgh arg of the runtime lua_pcall.
+// Receives the original error on the stack, returns a string that is
+// "<original>\nstack traceback:\n<frames…>".
+static int err_msgh(lua_State* l) {
+    const char* msg = lua_tostring(l, 1);
+    if (!msg) msg = "(non-string error)";
+    luaL_traceback(l, l, msg, 1);
+    return 1;
+}
+
+// Pops the error from the top of the Lua stack and, if error_func is set,
+// invokes it. For runtime errors (with_trace != 0), splits the combined
+// "msg\nstack traceback:\nframes" string from err_msgh into two parts.
+static void emit_lua_error(tinybit_ctx* ctx, lua_State* l, int with_trace) {
+    const char* raw = lua_tostring(l, -1);
+    if (!raw) raw = "(non-string error)";
+
+    if (ctx->error_func) {
+        if (with_trace) {
+            const char* sep = strstr(raw, "\nstack traceback:");
+            if (sep) {
+                size_t msg_len = (size_t)(sep - raw);
+                char* msg_buf = ctx->error_buffer;
+                if (msg_len >= sizeof(ctx->error_buffer)) msg_len = sizeof(ctx->error_buffer) - 1;
+                memcpy(msg_buf, raw, msg_len);
+                msg_buf[msg_len] = '\0';
+                const char* trace = sep + 1; // skip leading newline
+                ctx->error_func(ctx, msg_buf, trace);
+            } else {
+                ctx->error_func(ctx, raw, NULL);
+            }
+        } else {
+            ctx->error_func(ctx, raw, NULL);
+        }
+    }
+
+    lua_pop(l, 1);
+}
+
+// Milliseconds on the frame clock: the host's ticks, or the virtual clock
+// while tinybit_step() is running and in deterministic mode.
+static int frame_clock(tinybit_ctx* ctx) {
+    if (ctx->virtual_clock || ctx->deterministic) {
+        return (int)(ctx->virtual_frames * 1000 / TB_FRAME_RATE);
+    }
+    return ctx->get_ticks_ms_func(ctx);
+}
+
+// Seed random() and noise synthesis from the context seed, as two streams so
+// the numbers a game draws don't depend on how much audio was rendered
+static void seed_rng(tinybit_ctx* ctx) {
+    rng_seed(ctx->rng, ctx->seed);
+    rng_seed(ctx->noise_rng, ctx->seed ^ 0x6E6F697365ull); // "noise"
+}
+
+// Initialize a TinyBit context on top of the given memory block. Callbacks and
+// user data already set on the context are kept, so a re-init keeps the host wiring.
+void tinybit_init(tinybit_ctx* ctx, struct TinyBitMemory* memory) {
+    if (!ctx || !memory) {
+        return; // Error: null pointer
+    }
+
+    ctx->memory = memory;
+
+    // seed all randomness; deterministic mode keeps the host's seed
+    if (!ctx->deterministic) {
+        ctx->seed = (uint64_t)time(NULL) ^ (uint64_t)(uintptr_t)ctx;
+    }
+    seed_rng(ctx);
+
+    // initialize memory
+    memory_init(ctx);
+    lua_pool_reset(ctx);
+    tb_audio_init(ctx);
+    cartridge_init(ctx);
+    graphics_init(ctx);
+    font_init(ctx);
+    memset(ctx->prev_button_state, 0, sizeof(ctx->prev_button_state));
+    memset(ctx->update_button_state, 0, sizeof(ctx->update_button_state));
+
+    // reset frame loop state so a re-init mid-session starts from a clean slate
+    ctx->running = true;
+    ctx->sleep_ms = 0;
+    ctx->sleep_start_time = 0;
+    ctx->frame_time = 0;
+    ctx->virtual_clock = false;
+    ctx->virtual_frames = 0;
+    stats_reset(ctx);
+
+    // set up lua VM
+    ctx->L = lua_pool_newstate(ctx);
+
+    // add special functions to lua for reading game files
+    cartridge_register_lua(ctx->L);
+
+    // initialize the game loader as the default "game"
+    memcpy(ctx->memory->script, launcher, strlen(launcher) + 1); // copy script to memory
+}
+
+// Restart random() and math.random from the context seed so every start of
+// a cartridge in deterministic mode sees the same sequences
+static void reseed(tinybit_ctx* ctx) {
+    lua_State* L = ctx->L;
+
+    seed_rng(ctx);
+
+    lua_getglobal(L, LUA_MATHLIBNAME);
+    lua_getfield(L, -1, "randomseed");
+    lua_pushinteger(L, (lua_Integer)ctx->seed);
+    if (lua_pcall(L, 1, 0, 0) != LUA_OK) {
+        lua_pop(L, 1); // pop the error
+    }
+    lua_pop(L, 1); // pop the math table
+}
+
+// Start executing the Lua script currently loaded in memory
+bool tinybit_start(tinybit_ctx* ctx){
+    lua_State* L = ctx->L;
+    const char* script = (const char*)ctx->memory->script;
+    bool bytecode;
+    size_t script_len = cartridge_script(ctx, &bytecode);
+
+    if (ctx->deterministic) {
+        reseed(ctx);
+    }
+    ctx->update.primed = false;
+    spritesheet_changed(ctx); // loaded by the cartridge or written by the host
+
+    // binary chunks are only accepted from cartridges flagged as bytecode
+    int status = bytecode ? luaL_loadbufferx(L, script, script_len, "=script", "b")
+                          : chunk_cache_load(ctx, L, script, script_len);
+    if (status != LUA_OK) {
+        // Compile error — no Lua stack yet, so no traceback.
+        emit_lua_error(ctx, L, /*with_trace=*/0);
+        return false;
+    }
+
+    // Load succeeded — install the message handler below the loaded chunk so
+    // a top-level runtime error in the script gets a traceback.
+    int msgh_idx = lua_gettop(L);     // index of the loaded chunk
+    lua_pushcfunction(L, err_msgh);   // [..., chunk, err_msgh]
+    lua_insert(L, msgh_idx);          // [..., err_msgh, chunk]
+
+    watchdog_start(ctx);
+    watchdog_arm(ctx, L);
+    status = lua_pcall(L, 0, 0, msgh_idx);
+    watchdog_disarm(L);
+    if (status != LUA_OK) {
+        emit_lua_error(ctx, L, /*with_trace=*/1);
+        lua_remove(L, msgh_idx);
+        return false;
+    }
+    lua_remove(L, msgh_idx);
+
+    if (ctx->restart_snapshot) {
+        snapshot_capture(ctx, ctx->restart_snapshot);
+    }
+    return true;
+}
+
+// Compile source for a bytecode cartridge: set TB_HEADER_FLAG_BYTECODE,
+// script_size to the returned size, and the checksum over the chunk.
+// Compiles in the context's Lua heap, so use a context that isn't running
+// a game. Returns 0 on a compile error, if the chunk needs more than
+// capacity, or after tinybit_stop().
+size_t tinybit_compile(tinybit_ctx* ctx, const char* source, size_t size, uint8_t* out, size_t capacity) {
+    return cartridge_compile(ctx, source, size, out, capacity);
+}
+
+// Wrap every Lua API binding to count its calls, inclusive time and the
+// pixels it drew, per frame. Takes effect on the running cartridge's
+// globals (not on copies it already made) and on every later start.
+void tinybit_api_stats_enable(tinybit_ctx* ctx, bool enabled) {
+    lua_api_enable(ctx, enabled);
+}
+
+// The last frame's accounting, one entry per binding; returns the number
+// of entries written
+int tinybit_api_stats(tinybit_ctx* ctx, struct TinyBitApiStat* stats, int max) {
+    int count = ctx->api.count < max ? ctx->api.count : max;
+    memcpy(stats, ctx->api.last, (size_t)count * sizeof(stats[0]));
+    return count;
+}
+
+// Start the sampling profiler with its tables in buffer (a few KB go a long
+// way). The Lua call stack is recorded every interval VM instructions, or
+// on each tinybit_profile_tick() with TB_PROFILE_TIME (interval is then the
+// tick period in microseconds), and weighted by interval. Earlier results
+// are discarded.
+bool tinybit_profile_start(tinybit_ctx* ctx, void* buffer, size_t size, enum TinyBitProfileMode mode, uint32_t interval) {
+    return profiler_start(ctx, buffer, size, mode, interval);
+}
+
+void tinybit_profile_stop(tinybit_ctx* ctx) {
+    profiler_stop(ctx);
+}
+
+// The profile as folded stacks ("main;_update:3;move:40 1200" lines, for
+// flamegraph tools) into out, or through the log callback if out is NULL.
+// Returns the full output size, which may exceed capacity.
+size_t tinybit_profile_dump(tinybit_ctx* ctx, char* out, size_t capacity) {
+    return profiler_dump(ctx, out, capacity);
+}
+
+// With TB_PROFILE_TIME, call this from a host timer every interval
+// microseconds; it may run in a signal handler, interrupt or other thread
+void tinybit_profile_tick(tinybit_ctx* ctx) {
+    watchdog_profile_tick(ctx);
+}
+
+// Cache compiled text scripts in a host buffer, keyed by the CRC-32 of the
+// source, so restarting a recently run script skips the compiler. A NULL
+// buffer turns the cache off.
+void tinybit_chunk_cache(tinybit_ctx* ctx, void* buffer, size_t size) {
+    chunk_cache_init(ctx, buffer, size);
+}
+
+// Back to the state right after the restart snapshot was taken. The clock
+// keeps running, so pending sleeps are shifted to the current time.
+static bool restart_from_snapshot(tinybit_ctx* ctx) {
+    long now = ctx->frame_time;
+    uint64_t frames = ctx->virtual_frames;
+
+    if (!snapshot_matches_script(ctx, ctx->restart_snapshot)
+        || !snapshot_restore(ctx, ctx->restart_snapshot)) {
+        return false;
+    }
+    ctx->sleep_start_time += (int)(now - ctx->frame_time);
+    ctx->frame_time = now;
+    ctx->virtual_frames = frames;
+    return true;
+}
+
+// Reset the Lua state and start a new game
+bool tinybit_restart(tinybit_ctx* ctx){
+    if (ctx->restart_snapshot && restart_from_snapshot(ctx)) {
+        return true;
+    }
+
+    lua_close(ctx->L);
+    ctx->L = lua_pool_newstate(ctx);
+    draw_cls(ctx);
+    return tinybit_start(ctx);
+}
+
+// Signal the emulation loop to quit
+void tinybit_stop(tinybit_ctx* ctx) {
+    ctx->running = false;
+
+    lua_close(ctx->L);
+    ctx->L = NULL;
+
+    cartridge_destroy(ctx);
+}
+
+void tinybit_sleep(tinybit_ctx* ctx, int ms) {
+    ctx->sleep_ms = ms;
+    ctx->sleep_start_time = frame_clock(ctx);
+}
+
+// Current Lua heap usage in bytes; capacity is TB_MEM_LUA_STATE_SIZE.
+size_t tinybit_lua_memory_used(tinybit_ctx* ctx) {
+    return lua_pool_get_used(ctx);
+}
+
+// Walk the Lua heap and verify its layout; logs and returns false on damage.
+// Build with TB_HEAP_DEBUG to run this after every allocation.
+bool tinybit_lua_heap_check(tinybit_ctx* ctx) {
+    return lua_pool_validate(ctx);
+}
+
+// Peak, free space, fragmentation and allocation counters of the Lua heap
+void tinybit_lua_heap_stats(tinybit_ctx* ctx, struct TinyBitHeapStats* stats) {
+    lua_pool_stats(ctx, stats);
+}
+
+// Pages, objects in use and capacity of each small-object slab class
+void tinybit_lua_slab_stats(tinybit_ctx* ctx, struct TinyBitSlabStats stats[TB_SLAB_CLASSES]) {
+    lua_pool_slab_stats(ctx, stats);
+}
+
+// Deterministic mode: random(), math.random, noise synthesis and Lua's string
+// hash seed all derive from seed, and the frame clock advances 1000/60 ms per
+// frame in tinybit_loop as well as tinybit_step. Takes effect on the next
+// tinybit_start(); the Lua VM is rebuilt, so call it before starting a script.
+void tinybit_set_deterministic(tinybit_ctx* ctx, bool enabled, uint64_t seed) {
+    ctx->deterministic = enabled;
+    ctx->seed = enabled ? seed : (uint64_t)time(NULL) ^ (uint64_t)(uintptr_t)ctx;
+    seed_rng(ctx);
+
+    // the string hash seed is fixed when a state is created
+    if (ctx->L) {
+        lua_close(ctx->L);
+        ctx->L = lua_pool_newstate(ctx);
+        cartridge_register_lua(ctx->L);
+    }
+}
+
+// Limit the Lua work of each _draw call (and of the script's top level) to
+// a number of VM instructions and/or microseconds of the host clock; zero
+// means no limit. The instruction count is checked every 1000 instructions.
+// Past the budget, TB_BUDGET_ERROR raises a Lua error and TB_BUDGET_YIELD
+// suspends _draw until the next frame (falling back to an error where Lua
+// can't yield, such as the top level or inside C calls).
+void tinybit_set_frame_budget(tinybit_ctx* ctx, uint32_t instructions, uint32_t time_us, enum TinyBitBudgetMode mode) {
+    ctx->watchdog.instructions = instructions;
+    ctx->watchdog.time_us = time_us;
+    ctx->watchdog.mode = mode;
+}
+
+// With an _update function, how many renders in a row may be dropped to
+// keep the 60 Hz logic rate when frames run late (0, the default, drops
+// none: the game slows down instead)
+void tinybit_set_max_frameskip(tinybit_ctx* ctx, int frames) {
+    ctx->max_frameskip = frames > 0 ? frames : 0;
+}
+
+// Choose when the Lua garbage collector runs; applies to the running state
+// and every one created later. TB_GC_FRAME keeps collection out of _draw
+// and _update and spends the rest of the frame after rendering on it.
+void tinybit_set_gc_mode(tinybit_ctx* ctx, enum TinyBitGcMode mode) {
+    ctx->gc.mode = mode;
+    if (ctx->L) {
+        lua_pool_apply_gc_mode(ctx, ctx->L);
+    }
+}
+
+// Phase timings of the last frame plus rolling percentiles and heap usage
+void tinybit_frame_stats(tinybit_ctx* ctx, struct TinyBitFrameStats* stats) {
+    stats_get(ctx, stats);
+}
+
+// Record button input once per frame as a run-length encoded stream.
+// Recording stops early if the buffer fills; the stream stays valid.
+bool tinybit_record_start(tinybit_ctx* ctx, uint8_t* buffer, size_t capacity) {
+    return input_record_start(ctx, buffer, capacity);
+}
+
+// Stop recording; returns the number of bytes written to the buffer
+size_t tinybit_record_stop(tinybit_ctx* ctx) {
+    return input_record_stop(ctx);
+}
+
+// Take button input from a recorded stream instead of the input callback
+// until it runs out
+bool tinybit_replay_start(tinybit_ctx* ctx, const uint8_t* stream, size_t size) {
+    return input_replay_start(ctx, stream, size);
+}
+
+bool tinybit_replay_active(tinybit_ctx* ctx) {
+    return ctx->replay.active;
+}
+
+// Capture the whole machine between frames
+bool tinybit_snapshot(tinybit_ctx* ctx, struct TinyBitSnapshot* snap) {
+    if (!ctx->L || !snap) {
+        return false;
+    }
+    snapshot_capture(ctx, snap);
+    return true;
+}
+
+// Return to a snapshot taken from this context; false if it belongs elsewhere
+bool tinybit_restore(tinybit_ctx* ctx, const struct TinyBitSnapshot* snap) {
+    return snap && snapshot_restore(ctx, snap);
+}
+
+// With a snapshot buffer set, every successful tinybit_start() fills it and
+// tinybit_restart() of the same script restores it instead of re-running the
+// script. Pass NULL to turn it off.
+void tinybit_set_restart_snapshot(tinybit_ctx* ctx, struct TinyBitSnapshot* snap) {
+    ctx->restart_snapshot = snap;
+    if (snap) {
+        snap->valid = false;
+    }
+}
+
+// Give rewind a host buffer: one full machine state (sizeof(struct
+// TinyBitSnapshot)) plus compressed per-frame deltas in the rest, so the
+// buffer size is the memory budget. Pass NULL to turn rewind off.
+bool tinybit_rewind_buffer(tinybit_ctx* ctx, void* buffer, size_t size) {
+    return rewind_init(ctx, buffer, size);
+}
+
+// Step back up to frames frames; returns how many were rewound
+int tinybit_rewind(tinybit_ctx* ctx, int frames) {
+    if (!ctx->rewind.ring) {
+        return 0;
+    }
+    return rewind_frames(ctx, frames);
+}
+
+// Number of frames currently held in the rewind buffer
+int tinybit_rewind_available(tinybit_ctx* ctx) {
+    return ctx->rewind.frames;
+}
+
+// Feed cartridge PNG data to the TinyBit decoder
+bool tinybit_feed_cartridge(tinybit_ctx* ctx, const uint8_t* buffer, size_t size){
+    if (ctx->restart_snapshot) {
+        ctx->restart_snapshot->valid = false; // new cartridge, new assets
+    }
+    spritesheet_changed(ctx); // game assets or a cover image
+    return cartridge_feed(ctx, buffer, size);
+}
+
+void tinybit_set_user_data(tinybit_ctx* ctx, void* user_data) {
+    ctx->user_data = user_data;
+}
+
+void* tinybit_get_user_data(tinybit_ctx* ctx) {
+    return ctx->user_data;
+}
+
+// Call a cartridge callback under the frame budget. On error the traceback
+// is left on the stack.
+static int call_global(tinybit_ctx* ctx, const char* name) {
+    lua_State* L = ctx->L;
+
+    lua_pushcfunction(L, err_msgh);
+    int msgh_idx = lua_gettop(L);
+    lua_getglobal(L, name);
+    watchdog_arm(ctx, L);
+    int status = lua_pcall(L, 0, 1, msgh_idx);
+    watchdog_disarm(L);
+    if (status == LUA_OK) {
+        lua_pop(L, 1);          // pop the (unused) result
+    }
+    lua_remove(L, msgh_idx);    // pop the message handler
+    return status;
+}
+
+// Traceback of the failed coroutine (arg 1) for the error (arg 2)
+static int thread_traceback(lua_State* L) {
+    const char* msg = lua_tostring(L, 2);
+    luaL_traceback(L, lua_tothread(L, 1), msg ? msg : "(non-string error)", 0);
+    return 1;
+}
+
+// Run _draw in a coroutine so the budget can suspend it; a suspended call
+// is resumed instead of starting a new one. Returns LUA_YIELD while _draw is
+// still unfinished. On error the traceback, or just the error if there is
+// no memory for one, is left on the main stack.
+static int resume_draw(tinybit_ctx* ctx) {
+    lua_State* L = ctx->L;
+    lua_State* co;
+    int nresults;
+
+    int status = watchdog_draw_thread(L, &co);
+    if (status != LUA_OK) {
+        return status;
+    }
+    if (lua_status(co) != LUA_YIELD) {
+        lua_getglobal(co, "_draw");
+    }
+    watchdog_arm(ctx, co);
+    status = lua_resume(co, L, 0, &nresults);
+    watchdog_disarm(co);
+
+    if (status == LUA_OK || status == LUA_YIELD) {
+        lua_pop(co, nresults);
+        return status;
+    }
+    lua_xmove(co, L, 1); // the error
+    if (status != LUA_ERRMEM) {
+        // the traceback allocates, so it is built under protection too
+        lua_pushcfunction(L, thread_traceback);
+        lua_pushthread(co);
+        lua_xmove(co, L, 1);
+        lua_pushvalue(L, -3);
+        if (lua_pcall(L, 2, 1, 0) == LUA_OK) {
+            lua_replace(L, -2);
+        } else {
+            lua_pop(L, 1); // keep the plain error
+        }
+    }
+    lua_closethread(co, L); // reset it for the next call
+    return status;
+}
+
+// Number of _update calls due this frame. On the virtual clock that is one
+// per frame; otherwise elapsed time is accumulated in 1/TB_FRAME_RATE ms
+// units and at most max_frameskip + 1 steps are taken, dropping any backlog
+// beyond that so a slow machine slows the game down instead of spiraling.
+static int due_updates(tinybit_ctx* ctx) {
+    const int step = 1000;
+    long now = ctx->frame_time;
+
+    if (ctx->virtual_clock || ctx->deterministic) {
+        return 1;
+    }
+    if (!ctx->update.primed) {
+        ctx->update.primed = true;
+        ctx->update.last_clock = now;
+        return 1;
+    }
+
+    ctx->update.accumulator += (now - ctx->update.last_clock) * TB_FRAME_RATE;
+    ctx->update.last_clock = now;
+
+    int max_updates = ctx->max_frameskip + 1;
+    int updates = ctx->update.accumulator / step;
+    if (updates > max_updates) {
+        updates = max_updates;
+        ctx->update.accumulator = 0;
+    } else {
+        ctx->update.accumulator -= updates * step;
+    }
+    return updates;
+}
+
+// Tell the host the Lua heap ran short. A dropped frame first gets a full
+// collection, so the next frame retries with everything that can be freed.
+static void report_memory(tinybit_ctx* ctx, enum TinyBitMemoryEvent event) {
+    ctx->lua_heap.pressure = false;
+    if (event == TB_MEMORY_FRAME_DROPPED) {
+        lua_pool_recover(ctx);
+    }
+    if (ctx->memory_func) {
+        struct TinyBitHeapStats stats;
+        lua_pool_stats(ctx, &stats);
+        ctx->memory_func(ctx, event, &stats);
+    }
+}
+
+static bool has_update(tinybit_ctx* ctx) {
+    bool found = lua_getglobal(ctx->L, "_update") == LUA_TFUNCTION;
+    lua_pop(ctx->L, 1);
+    return found;
+}
+
+// Run the cartridge's logic for this frame. Returns false if _draw (and so
+// rendering) is skipped: with an _update function, _update runs at a fixed
+// TB_FRAME_RATE and _draw once after it, or not at all if no step was due.
+static bool run_logic(tinybit_ctx* ctx) {
+    lua_State* L = ctx->L;
+    int updates = 0;
+    int status = LUA_OK;
+
+    bool fixed_step = has_update(ctx);
+    watchdog_start(ctx); // one budget for all of this frame's _update steps and _draw
+
+    if (fixed_step) {
+        updates = due_updates(ctx);
+        for (int i = 0; i < updates && status == LUA_OK; i++) {
+            save_update_button_state(ctx); // btnp() edges belong to one update
+            status = call_global(ctx, "_update");
+        }
+        if (updates > 1) {
+            ctx->stats.skipped_draws += updates - 1;
+        }
+    }
+
+    if (status == LUA_OK && (!fixed_step || updates > 0)) {
+        status = ctx->watchdog.mode == TB_BUDGET_YIELD ? resume_draw(ctx) : call_global(ctx, "_draw");
+    }
+
+    // the display holds a half-drawn frame until _draw finishes
+    if (status == LUA_YIELD) {
+        ctx->stats.suspended_draws++;
+        return false;
+    }
+
+    // Out of memory even after Lua's emergency collection: drop the frame
+    // and let the next one retry with whatever a full collection frees,
+    // unless that keeps failing
+    if (status == LUA_ERRMEM && ctx->heap_stats.dropped_run < TB_MEMORY_MAX_DROPPED) {
+        lua_pop(L, 1);
+        ctx->heap_stats.dropped_frames++;
+        ctx->heap_stats.dropped_run++;
+        report_memory(ctx, TB_MEMORY_FRAME_DROPPED);
+        return false;
+    }
+    if (status == LUA_OK) {
+        ctx->heap_stats.dropped_run = 0;
+        if (ctx->lua_heap.pressure) {
+            report_memory(ctx, TB_MEMORY_RECLAIMED);
+        }
+    }
+
+    if (status != LUA_OK) {
+        if (status == LUA_ERRMEM) {
+            ctx->heap_stats.dropped_run = 0;
+            report_memory(ctx, TB_MEMORY_EXHAUSTED);
+        }
+        emit_lua_error(ctx, L, /*with_trace=*/1); // pops the error (with traceback)
+        audio_stop_all(ctx);
+        // error_screen is a hand-written clean script; tinybit_restart()
+        // will tinybit_start() it and the new path will not re-fire emit_lua_error.
+        strcpy((char*)ctx->memory->script, error_screen);
+        tinybit_restart(ctx);
+    }
+    return !fixed_step || updates > 0;
+}
+
+// Run one frame - handles input, executes Lua draw function, and renders.
+// flags is a mask of TB_STEP_* values selecting the phases to skip.
+static void run_frame(tinybit_ctx* ctx, int flags) {
+    uint32_t phase_us[TB_PHASE_COUNT];
+    uint64_t frame_start;
+    uint64_t phase_start;
+    bool drawn = true;
+
+    ctx->frame_time = frame_clock(ctx);
+    frame_start = stats_clock_us(ctx);
+    phase_start = frame_start;
+
+    // INPUT
+    input_poll(ctx);
+    phase_us[TB_PHASE_INPUT] = stats_lap_us(ctx, &phase_start);
+
+    // LOGIC
+    if(ctx->sleep_ms == 0 || frame_clock(ctx) - ctx->sleep_start_time >= ctx->sleep_ms) {
+        ctx->sleep_ms = 0;
+        drawn = run_logic(ctx);
+    } else {
+        ctx->update.last_clock = ctx->frame_time; // time asleep isn't owed to _update
+    }
+
+    // deferred game load
+    if (cartridge_load_pending(ctx)) {
+        return;
+    }
+
+    phase_us[TB_PHASE_DRAW] = stats_lap_us(ctx, &phase_start);
+
+    // save current button state; _update steps keep their own
+    if (!has_update(ctx)) {
+        save_button_state(ctx);
+    }
+
+    // AUDIO
+    if (flags & TB_STEP_SKIP_AUDIO) {
+        audio_skip_frame(ctx); // keep playback position (and sfx_active) in sync
+    } else {
+        process_audio(ctx);
+        if (ctx->audio_queue_func) {
+            ctx->audio_queue_func(ctx);
+        }
+    }
+    phase_us[TB_PHASE_AUDIO] = stats_lap_us(ctx, &phase_start);
+
+    // RENDER
+    if (ctx->frame_func && drawn && !(flags & TB_STEP_SKIP_RENDER)) {
+        ctx->frame_func(ctx);
+    }
+    phase_us[TB_PHASE_DISPLAY] = stats_lap_us(ctx, &phase_start);
+
+    // GC
+    if (ctx->gc.mode == TB_GC_FRAME) {
+        lua_pool_gc_frame(ctx, frame_start + 1000000 / TB_FRAME_RATE);
+    }
+    phase_us[TB_PHASE_GC] = stats_lap_us(ctx, &phase_start);
+
+    phase_us[TB_PHASE_FRAME] = stats_lap_us(ctx, &frame_start);
+    stats_record_frame(ctx, phase_us);
+    if (ctx->api.enabled) {
+        lua_api_end_frame(ctx);
+    }
+}
+
+// Main emulation loop - runs one frame against the host clock (or the
+// virtual clock in deterministic mode)
+void tinybit_loop(tinybit_ctx* ctx) {
+    run_frame(ctx, 0);
+    ctx->virtual_frames++;
+    if (ctx->rewind.ring) {
+        rewind_capture(ctx);
+    }
+}
+
+// Run n frames back-to-back on a virtual clock that advances 1000/60 ms per
+// frame; get_ticks_ms is never read. Returns the number of frames run, which
+// is less than n only if the context was stopped.
+int tinybit_step(tinybit_ctx* ctx, int n, int flags) {
+    int i;
+
+    ctx->virtual_clock = true;
+    for (i = 0; i < n && ctx->running; i++) {
+        run_frame(ctx, flags);
+        ctx->virtual_frames++;
+        if (ctx->rewind.ring) {
+            rewind_capture(ctx);
+        }
+    }
+    ctx->virtual_clock = false;
+
+    return i;
+}
+
+// Set callback function that gets called when a new frame should be drawn
+void tinybit_render_cb(tinybit_ctx* ctx, void (*render_func_ptr)(tinybit_ctx* ctx)) {
+    if (!render_func_ptr) {
+        return; // Error: null pointer
+    }
+
+    ctx->frame_func = render_func_ptr;
+}
+
+// Set callback function that gets called to read button state
+void tinybit_poll_input_cb(tinybit_ctx* ctx, void (*poll_input_func_ptr)(tinybit_ctx* ctx)) {
+    if (!poll_input_func_ptr) {
+        return; // Error: null pointer
+    }
+
+    ctx->input_func = poll_input_func_ptr;
+}
+
+void tinybit_log_cb(tinybit_ctx* ctx, void (*log_func_ptr)(tinybit_ctx* ctx, const char* message)){
+    if (!log_func_ptr) {
+        return; // Error: null pointer
+    }
+
+    ctx->log_func = log_func_ptr;
+}
+
+void tinybit_error_cb(tinybit_ctx* ctx, void (*error_func_ptr)(tinybit_ctx* ctx, const char* message, const char* traceback)) {
+    ctx->error_func = error_func_ptr;
+}
+
+void tinybit_memory_cb(tinybit_ctx* ctx, void (*memory_func_ptr)(tinybit_ctx* ctx, enum TinyBitMemoryEvent event, const struct TinyBitHeapStats* stats)) {
+    ctx->memory_func = memory_func_ptr;
+}
+
+void tinybit_get_ticks_ms_cb(tinybit_ctx* ctx, int (*get_ticks_ms_func_ptr)(tinybit_ctx* ctx)) {
+    if (!get_ticks_ms_func_ptr) {
+        return; // Error: null pointer
+    }
+
+    ctx->get_ticks_ms_func = get_ticks_ms_func_ptr;
+}
+
+// Optional microsecond clock for frame stats; without it, phase timings
+// have the millisecond clock's resolution
+void tinybit_get_ticks_us_cb(tinybit_ctx* ctx, uint64_t (*get_ticks_us_func_ptr)(tinybit_ctx* ctx)) {
+    ctx->get_ticks_us_func = get_ticks_us_func_ptr;
+}
+
+// Set callback function for queuing audio each frame
+void tinybit_audio_queue_cb(tinybit_ctx* ctx, void (*audio_queue_func_ptr)(tinybit_ctx* ctx)) {
+    if (!audio_queue_func_ptr) {
+        return; // Error: null pointer
+    }
+
+    ctx->audio_queue_func = audio_queue_func_ptr;
+}
+
+void tinybit_gamecount_cb(tinybit_ctx* ctx, int (*gamecount_func_ptr)(tinybit_ctx* ctx)) {
+    if (!gamecount_func_ptr) {
+        return;
+    }
+    ctx->gamecount_func = gamecount_func_ptr;
+}
+
+void tinybit_gameload_cb(tinybit_ctx* ctx, void (*gameload_func_ptr)(tinybit_ctx* ctx, int index)) {
+    if (!gameload_func_ptr) {
+        return;
+    }
+    ctx->gameload_func = gameload_func_ptr;
+}
@@ -1,98 +1,499 @@
-#ifndef TINYBIT_H
-#define TINYBIT_H
-
-#include <stdint.h>
-#include <stdbool.h>
-#include <stddef.h>
-
-// cartridge dimensions
-#define TB_CARTRIDGE_WIDTH 256
-#define TB_CARTRIDGE_HEIGHT 256
-
-// Screen dimensions
-#define TB_SCREEN_WIDTH 128
-#define TB_SCREEN_HEIGHT 128
-
-// Audio configuration
-#define TB_AUDIO_SAMPLE_RATE 22000
-#define TB_AUDIO_FRAME_SAMPLES 367 // samples per 60fps frame
-
-// define cover location
-#define TB_COVER_X 64
-#define TB_COVER_Y 64
-
-// Cartridge header (on-disk layout, little-endian, 146 bytes)
-#define TB_HEADER_TITLE_SIZE    64
-#define TB_HEADER_AUTHOR_SIZE   64
-#define TB_HEADER_SIZE          146
-
-struct TinyBitHeader {
-    uint16_t format_version;
-    uint16_t flags;
-    uint32_t script_size;
-    uint32_t checksum;      // CRC-32 (IEEE 802.3) of the lua script bytes
-    char     title[TB_HEADER_TITLE_SIZE];
-    char     author[TB_HEADER_AUTHOR_SIZE];
-    uint16_t game_version;
-    uint32_t package_date;
-};
-
-// Memory sizes
-#define TB_MEM_SPRITESHEET_SIZE     (TB_SCREEN_WIDTH * TB_SCREEN_HEIGHT * 2) // 32Kb
-#define TB_MEM_DISPLAY_SIZE         (TB_SCREEN_WIDTH * TB_SCREEN_HEIGHT * 2) // 32Kb
-#define TB_MEM_SCRIPT_SIZE          (32 * 1024 - TB_HEADER_SIZE) // 32622 bytes; matches cartridge script payload
-#define TB_MEM_LUA_STATE_SIZE       (256 * 1024) // 256Kb
-#define TB_MEM_AUDIO_DATA_SIZE      (12 * 1024) // 12Kb
-#define TB_MEM_PNGLE_SIZE           (48 * 1024) // 48Kb
-#define TB_MEM_AUDIO_BUFFER_SIZE    (TB_AUDIO_FRAME_SAMPLES * 2) // 734 bytes (367 16-bit samples)
-#define TB_MEM_BUTTON_INPUT_SIZE    8 // 8 bytes (button inputs)
-#define TB_MEM_USER_SIZE            (10 * 1024) // 10Kb
-
-struct TinyBitMemory {
-    uint8_t  header[TB_HEADER_SIZE];
-    uint16_t spritesheet[TB_SCREEN_WIDTH * TB_SCREEN_HEIGHT];
-    uint16_t display[TB_SCREEN_WIDTH * TB_SCREEN_HEIGHT];
-    uint8_t  script[TB_MEM_SCRIPT_SIZE];
-    uint8_t  lua_state[TB_MEM_LUA_STATE_SIZE];
-    uint8_t  audio_data[TB_MEM_AUDIO_DATA_SIZE];
-    uint8_t  pngle_data[TB_MEM_PNGLE_SIZE];
-    int16_t  audio_buffer[TB_AUDIO_FRAME_SAMPLES];
-    uint8_t  button_input[TB_MEM_BUTTON_INPUT_SIZE];
-    uint8_t  user[TB_MEM_USER_SIZE];
-};
-
-#define TB_MEM_SIZE (sizeof(struct TinyBitMemory))
-
-enum TinyBitButton {
-    TB_BUTTON_A,
-    TB_BUTTON_B,
-    TB_BUTTON_UP,
-    TB_BUTTON_DOWN,
-    TB_BUTTON_LEFT,
-    TB_BUTTON_RIGHT,
-    TB_BUTTON_START,
-    TB_BUTTON_SELECT,
-    TB_BUTTON_COUNT
-};
-
-// Core TinyBit API functions
-void tinybit_init(struct TinyBitMemory* memory);
-bool tinybit_feed_cartridge(const uint8_t* cartridge_buffer, size_t bytes);
-bool tinybit_start();
-bool tinybit_restart();
-void tinybit_loop();
-void tinybit_stop();
-void tinybit_sleep(int ms);
-size_t tinybit_lua_memory_used();
-
-// Callback function setters
-void tinybit_log_cb(void (*log_func_ptr)(const char*));
-void tinybit_get_ticks_ms_cb(int (*get_ticks_ms_func_ptr)());
-void tinybit_render_cb(void (*render_func_ptr)());
-void tinybit_poll_input_cb(void (*poll_input_func_ptr)());
-void tinybit_audio_queue_cb(void (*audio_queue_func_ptr)());
-void tinybit_gamecount_cb(int (*gamecount_func_ptr)());
-void tinybit_gameload_cb(void (*gameload_func_ptr)(int index));
-void tinybit_error_cb(void (*error_func_ptr)(const char* message, const char* traceback));
-
+#ifndef TINYBIT_H
+#define TINYBIT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// cartridge dimensions
+#define TB_CARTRIDGE_WIDTH 256
+#define TB_CARTRIDGE_HEIGHT 256
+
+// Screen dimensions
+#define TB_SCREEN_WIDTH 128
+#define TB_SCREEN_HEIGHT 128
+#define TB_SPRITE_CELLS ((TB_SCREEN_WIDTH / 8) * (TB_SCREEN_HEIGHT / 8)) // 8x8 spritesheet cells
+
+// Tilemap dimensions, in cells
+#define TB_MAP_WIDTH 128
+#define TB_MAP_HEIGHT 64
+
+// Frame and audio configuration
+#define TB_FRAME_RATE 60
+#define TB_AUDIO_SAMPLE_RATE 22000
+#define TB_AUDIO_FRAME_SAMPLES 367 // samples per 60fps frame
+
+// define cover location
+#define TB_COVER_X 64
+#define TB_COVER_Y 64
+
+// Cartridge header (on-disk layout, little-endian, 146 bytes)
+#define TB_HEADER_TITLE_SIZE    64
+#define TB_HEADER_AUTHOR_SIZE   64
+#define TB_HEADER_SIZE          146
+
+struct TinyBitHeader {
+    uint16_t format_version;
+    uint16_t flags;
+    uint32_t script_size;
+    uint32_t checksum;      // CRC-32 (IEEE 802.3) of the lua script bytes
+    char     title[TB_HEADER_TITLE_SIZE];
+    char     author[TB_HEADER_AUTHOR_SIZE];
+    uint16_t game_version;
+    uint32_t package_date;
+};
+
+// Header flags
+#define TB_HEADER_FLAG_BYTECODE (1 << 0) // script is a binary chunk from tinybit_compile(), script_size bytes
+
+// Memory sizes
+#define TB_MEM_SPRITESHEET_SIZE     (TB_SCREEN_WIDTH * TB_SCREEN_HEIGHT * 2) // 32Kb
+#define TB_MEM_TILEMAP_SIZE         (TB_MAP_WIDTH * TB_MAP_HEIGHT) // 8Kb
+#define TB_MEM_DISPLAY_SIZE         (TB_SCREEN_WIDTH * TB_SCREEN_HEIGHT * 2) // 32Kb
+#define TB_MEM_SCRIPT_SIZE          (32 * 1024 - TB_HEADER_SIZE) // 32622 bytes; matches cartridge script payload
+#define TB_MEM_LUA_STATE_SIZE       (256 * 1024) // 256Kb
+#define TB_MEM_AUDIO_DATA_SIZE      (12 * 1024) // 12Kb
+#define TB_MEM_PNGLE_SIZE           (48 * 1024) // 48Kb
+#define TB_MEM_AUDIO_BUFFER_SIZE    (TB_AUDIO_FRAME_SAMPLES * 2) // 734 bytes (367 16-bit samples)
+#define TB_MEM_BUTTON_INPUT_SIZE    8 // 8 bytes (button inputs)
+#define TB_MEM_USER_SIZE            (10 * 1024) // 10Kb
+
+struct TinyBitMemory {
+    uint8_t  header[TB_HEADER_SIZE];
+    uint16_t spritesheet[TB_SCREEN_WIDTH * TB_SCREEN_HEIGHT];
+    uint16_t display[TB_SCREEN_WIDTH * TB_SCREEN_HEIGHT];
+    uint8_t  script[TB_MEM_SCRIPT_SIZE];
+    uint8_t  lua_state[TB_MEM_LUA_STATE_SIZE];
+    uint8_t  audio_data[TB_MEM_AUDIO_DATA_SIZE];
+    uint8_t  pngle_data[TB_MEM_PNGLE_SIZE];
+    int16_t  audio_buffer[TB_AUDIO_FRAME_SAMPLES];
+    uint8_t  button_input[TB_MEM_BUTTON_INPUT_SIZE];
+    uint8_t  user[TB_MEM_USER_SIZE];
+    uint8_t  tilemap[TB_MEM_TILEMAP_SIZE]; // last, so older regions keep their addresses
+};
+
+#define TB_MEM_SIZE (sizeof(struct TinyBitMemory))
+
+enum TinyBitButton {
+    TB_BUTTON_A,
+    TB_BUTTON_B,
+    TB_BUTTON_UP,
+    TB_BUTTON_DOWN,
+    TB_BUTTON_LEFT,
+    TB_BUTTON_RIGHT,
+    TB_BUTTON_START,
+    TB_BUTTON_SELECT,
+    TB_BUTTON_COUNT
+};
+
+// Frame phases timed by the built-in stats (TB_PHASE_FRAME is the whole frame)
+enum TinyBitPhase {
+    TB_PHASE_INPUT,
+    TB_PHASE_DRAW,    // Lua _draw
+    TB_PHASE_AUDIO,
+    TB_PHASE_DISPLAY, // render callback
+    TB_PHASE_GC,      // scheduled garbage collection (TB_GC_FRAME)
+    TB_PHASE_FRAME,
+    TB_PHASE_COUNT
+};
+
+#define TB_STATS_WINDOW 128 // frames kept for the rolling percentiles
+#define TB_CHUNK_CACHE_ENTRIES 8 // scripts kept by tinybit_chunk_cache()
+
+struct TinyBitPercentiles {
+    uint32_t p50_us;
+    uint32_t p95_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+};
+
+// Snapshot returned by tinybit_frame_stats()
+struct TinyBitFrameStats {
+    uint64_t frames;                 // frames measured since tinybit_init
+    uint64_t budget_overruns;        // frames that took longer than 1/60 s
+    uint32_t window;                 // frames covered by percentiles (<= TB_STATS_WINDOW)
+    uint32_t last_us[TB_PHASE_COUNT];
+    struct TinyBitPercentiles percentiles[TB_PHASE_COUNT];
+    size_t lua_heap_used;
+    size_t lua_heap_peak;
+    uint64_t watchdog_trips;         // frames cut short by the Lua budget
+    uint64_t skipped_draws;          // _draw calls dropped to keep _update at 60 Hz
+    uint64_t suspended_draws;        // frames not presented while a suspended _draw finishes
+};
+
+// Small Lua objects come from slabs of fixed-size objects, one class per
+// 8 bytes up to TB_SLAB_CLASSES * 8
+#define TB_SLAB_CLASSES 8
+
+// Occupancy of one slab class, from tinybit_lua_slab_stats()
+struct TinyBitSlabStats {
+    uint32_t object_size;
+    uint32_t pages;            // 1 KB pages held by the class
+    uint32_t objects_used;
+    uint32_t objects_capacity;
+};
+
+// Allocation size buckets in TinyBitHeapStats: up to 16, 32, ... 16K bytes,
+// then everything larger
+#define TB_HEAP_BUCKETS 12
+
+// Lua heap telemetry from tinybit_lua_heap_stats()
+struct TinyBitHeapStats {
+    size_t capacity;             // bytes the allocator manages
+    size_t used;                 // bytes held by Lua
+    size_t peak;                 // highest used since tinybit_init
+    size_t free_bytes;           // in free blocks (spare slab objects not included)
+    size_t largest_free;         // largest free block
+    uint32_t free_blocks;
+    float fragmentation;         // 1 - largest_free / free_bytes; 0 = one free block
+    uint64_t allocations[TB_HEAP_BUCKETS];
+    uint64_t failed_allocations; // requests refused, before Lua's emergency GC retry
+    uint32_t dropped_frames;     // frames cut short by a memory error
+};
+
+// Per-binding accounting from tinybit_api_stats(), for the last frame
+#define TB_API_MAX_BINDINGS 48
+
+struct TinyBitApiStat {
+    const char* name;   // Lua global name
+    uint32_t calls;
+    uint32_t time_us;   // inclusive time in the binding
+    uint32_t pixels;    // pixels the rasterizer visited during the calls
+};
+
+// Low-memory events passed to the memory callback
+enum TinyBitMemoryEvent {
+    TB_MEMORY_RECLAIMED,     // an allocation failed but succeeded after collection
+    TB_MEMORY_FRAME_DROPPED, // a callback ran out of memory; the game goes on next frame
+    TB_MEMORY_EXHAUSTED,     // out of memory TB_MEMORY_MAX_DROPPED frames in a row; cartridge stopped
+};
+
+// Consecutive out-of-memory frames tolerated before the error screen
+#define TB_MEMORY_MAX_DROPPED 30
+
+// Phases tinybit_step() can leave out of each frame
+enum TinyBitStepFlags {
+    TB_STEP_SKIP_RENDER = 1 << 0, // don't call the render callback
+    TB_STEP_SKIP_AUDIO  = 1 << 1, // advance playback without synthesizing or queuing samples
+};
+
+// When the Lua garbage collector runs
+enum TinyBitGcMode {
+    TB_GC_INCREMENTAL,  // incremental, paced by allocation (pause 120, stepmul 200)
+    TB_GC_GENERATIONAL, // Lua's generational collector
+    TB_GC_FRAME,        // no collection inside Lua callbacks; steps after the render callback
+};
+
+// What happens when _draw runs past its per-frame budget
+enum TinyBitBudgetMode {
+    TB_BUDGET_ERROR, // raise a Lua error: error screen, like any runtime error
+    TB_BUDGET_YIELD, // suspend _draw and resume it on the next frame
+};
+
+// What the profiler's sampling interval counts
+enum TinyBitProfileMode {
+    TB_PROFILE_INSTRUCTIONS, // sample every interval VM instructions, weighted by instructions
+    TB_PROFILE_TIME,         // sample every interval microseconds, weighted by microseconds
+};
+
+#define TB_MAX_POLYGON_POINTS       32
+#define TB_LOG_BUFFER_SIZE          256
+#define TB_ERROR_MESSAGE_SIZE       4096
+
+struct lua_State;
+struct _pngle_t;
+struct channel_state;
+struct TinyBitSnapshot;
+
+typedef struct tinybit_ctx tinybit_ctx;
+
+// Per-instance engine state. Every running cartridge owns one context; all
+// public functions take it as their first argument, so independent sessions
+// can run side by side in one process (one context per thread at a time).
+// The host allocates it zero-initialized (statically or on the heap) and
+// passes it to tinybit_init(); the fields below are internal to the library.
+struct tinybit_ctx {
+    struct TinyBitMemory* memory;
+    void* user_data;
+
+    // deterministic mode (kept across tinybit_init, like the callbacks)
+    bool deterministic;
+    uint64_t seed;
+
+    // host buffer holding the state right after tinybit_start(), used by
+    // tinybit_restart() instead of re-running the script (snapshot.c)
+    struct TinyBitSnapshot* restart_snapshot;
+
+    // host callbacks
+    void (*frame_func)(tinybit_ctx* ctx);
+    void (*input_func)(tinybit_ctx* ctx);
+    int  (*get_ticks_ms_func)(tinybit_ctx* ctx);
+    uint64_t (*get_ticks_us_func)(tinybit_ctx* ctx);
+    void (*audio_queue_func)(tinybit_ctx* ctx);
+    void (*log_func)(tinybit_ctx* ctx, const char* message);
+    void (*error_func)(tinybit_ctx* ctx, const char* message, const char* traceback);
+    int  (*gamecount_func)(tinybit_ctx* ctx);
+    void (*gameload_func)(tinybit_ctx* ctx, int index);
+    void (*memory_func)(tinybit_ctx* ctx, enum TinyBitMemoryEvent event, const struct TinyBitHeapStats* stats);
+
+    // frame loop (tinybit.c)
+    struct lua_State* L;
+    bool running;
+    int sleep_ms;
+    int sleep_start_time;
+    long frame_time;
+    bool virtual_clock;
+    uint64_t virtual_frames;
+    uint32_t rng[4];       // xoshiro128** state for random() (rng.h)
+    uint32_t noise_rng[4]; // separate stream for noise synthesis
+    int max_frameskip;
+
+    // fixed-rate _update scheduling (tinybit.c)
+    struct {
+        bool primed;
+        long last_clock;
+        long accumulator; // in 1/TB_FRAME_RATE ms
+    } update;
+
+    // Lua heap bookkeeping (lua_pool.c); the heap itself is memory->lua_state
+    struct {
+        bool initialized;
+        size_t used;
+        bool pressure;       // an allocation failed since the last frame
+    } lua_heap;
+
+    // Lua heap telemetry for the host; not part of snapshots
+    struct {
+        size_t peak;
+        uint64_t allocations[TB_HEAP_BUCKETS];
+        uint64_t failed;
+        uint64_t allocated;  // total bytes ever requested
+        uint32_t dropped_frames;
+        uint32_t dropped_run; // consecutive dropped frames
+    } heap_stats;
+
+    // garbage collector policy (lua_pool.c)
+    struct {
+        enum TinyBitGcMode mode;
+        uint64_t allocated_mark;  // heap_stats.allocated at the last frame step
+    } gc;
+
+    // per-frame Lua budget (watchdog.c); zero limits mean unlimited
+    struct {
+        uint32_t instructions;
+        uint32_t time_us;
+        enum TinyBitBudgetMode mode;
+        int64_t remaining;
+        uint64_t start_us;
+        uint32_t interval;    // instructions between hook calls
+    } watchdog;
+
+    // sampling profiler; its tables live in a host buffer (profiler.c)
+    struct {
+        bool active;
+        enum TinyBitProfileMode mode;
+        uint32_t interval;
+        int64_t countdown;    // instructions to the next sample
+        struct lua_State* volatile thread;  // running Lua code, for timer samples
+        volatile bool sample_pending;
+        struct profile_frame* frames;
+        struct profile_stack* stacks;
+        uint32_t frame_mask;
+        uint32_t stack_mask;
+        uint32_t frame_count;
+        uint32_t stack_count;
+        uint64_t samples;
+        uint64_t dropped;     // samples lost to full tables
+    } profile;
+
+    // rolling frame timings (stats.c)
+    struct {
+        uint64_t frames;
+        uint64_t overruns;
+        uint64_t watchdog_trips;
+        uint64_t skipped_draws;
+        uint64_t suspended_draws;
+        uint32_t last_us[TB_PHASE_COUNT];
+        uint32_t history[TB_PHASE_COUNT][TB_STATS_WINDOW];
+    } stats;
+
+    // Lua API call accounting (lua_functions.c); the bindings are wrapped
+    // and the drawing code counts pixels only while enabled
+    struct {
+        bool enabled;
+        uint64_t pixels;
+        int count;
+        struct TinyBitApiStat frame[TB_API_MAX_BINDINGS]; // being collected
+        struct TinyBitApiStat last[TB_API_MAX_BINDINGS];  // last finished frame
+    } api;
+
+    // drawing state (graphics.c)
+    struct {
+        uint16_t fillColor;
+        uint16_t strokeColor;
+        int strokeWidth;
+        struct { int x, y; } polygon_points[TB_MAX_POLYGON_POINTS];
+        int polygon_point_count;
+        // alpha class of each spritesheet cell and of each 8-pixel row span
+        // of a cell; cells flagged in dirty_cells are reclassified on use
+        bool sheet_dirty;
+        uint32_t dirty_cells[TB_SPRITE_CELLS / 32];
+        uint8_t cell_class[TB_SPRITE_CELLS];
+        uint8_t span_class[TB_SCREEN_HEIGHT][TB_SCREEN_WIDTH / 8];
+    } graphics;
+
+    // text state (font.c)
+    struct {
+        int cursorX;
+        int cursorY;
+        uint16_t textColor;
+    } font;
+
+    // previous frame's buttons, for btnp (input.c)
+    bool prev_button_state[TB_BUTTON_COUNT];
+    bool update_button_state[TB_BUTTON_COUNT]; // as the last _update saw them
+
+    // input recording into a host buffer (input.c)
+    struct {
+        uint8_t* buffer;
+        size_t capacity;
+        size_t length;
+        uint8_t mask;
+        uint32_t run;
+        bool active;
+    } record;
+
+    // input replay from a recorded stream (input.c)
+    struct {
+        const uint8_t* stream;
+        size_t size;
+        size_t pos;
+        uint8_t mask;
+        uint32_t run;
+        bool active;
+    } replay;
+
+    // rewind history in a host buffer: newest state plus backward deltas (rewind.c)
+    struct {
+        struct TinyBitSnapshot* ref;
+        uint8_t* ring;
+        size_t capacity;
+        size_t head;
+        size_t tail;
+        size_t used;
+        int frames;
+    } rewind;
+
+    // compiled scripts in a host buffer, least recently used evicted first (chunk_cache.c)
+    struct {
+        uint8_t* buffer;
+        size_t capacity;
+        struct TinyBitChunkEntry {
+            uint32_t crc;         // CRC-32 of the source
+            uint32_t source_size;
+            size_t offset;        // chunk bytes in buffer
+            size_t size;
+            uint32_t last_used;
+        } entries[TB_CHUNK_CACHE_ENTRIES];
+        int count;
+        uint32_t clock;
+        uint32_t hits;
+        uint32_t misses;
+    } chunk_cache;
+
+    // channel states, carved out of memory->audio_data (audio.c)
+    struct channel_state* channels;
+
+    // cartridge decoder state (cartridge.c); pngle lives in memory->pngle_data
+    struct {
+        struct _pngle_t* pngle;
+        size_t index;
+        int pending_gameload;
+        struct TinyBitHeader header;
+        bool header_parsed;
+    } cartridge;
+
+    char log_buffer[TB_LOG_BUFFER_SIZE];
+    char error_buffer[TB_ERROR_MESSAGE_SIZE];
+};
+
+// Whole-machine state: TinyBitMemory (Lua heap, audio channels, decoder
+// included) plus the engine fields of the context. Snapshots hold absolute
+// pointers into the memory block, so they can only be restored into the
+// context and memory they were taken from.
+struct TinyBitSnapshot {
+    bool valid;
+    const tinybit_ctx* owner;
+    const struct TinyBitMemory* owner_memory;
+    struct TinyBitMemory memory;
+    tinybit_ctx state;
+};
+
+// Core TinyBit API functions
+void tinybit_init(tinybit_ctx* ctx, struct TinyBitMemory* memory);
+bool tinybit_feed_cartridge(tinybit_ctx* ctx, const uint8_t* cartridge_buffer, size_t bytes);
+bool tinybit_start(tinybit_ctx* ctx);
+bool tinybit_restart(tinybit_ctx* ctx);
+void tinybit_loop(tinybit_ctx* ctx);
+int tinybit_step(tinybit_ctx* ctx, int n, int flags);
+void tinybit_stop(tinybit_ctx* ctx);
+void tinybit_sleep(tinybit_ctx* ctx, int ms);
+size_t tinybit_lua_memory_used(tinybit_ctx* ctx);
+bool tinybit_lua_heap_check(tinybit_ctx* ctx);
+void tinybit_lua_heap_stats(tinybit_ctx* ctx, struct TinyBitHeapStats* stats);
+void tinybit_lua_slab_stats(tinybit_ctx* ctx, struct TinyBitSlabStats stats[TB_SLAB_CLASSES]);
+void tinybit_frame_stats(tinybit_ctx* ctx, struct TinyBitFrameStats* stats);
+void tinybit_set_deterministic(tinybit_ctx* ctx, bool enabled, uint64_t seed);
+void tinybit_set_max_frameskip(tinybit_ctx* ctx, int frames);
+void tinybit_set_gc_mode(tinybit_ctx* ctx, enum TinyBitGcMode mode);
+void tinybit_set_frame_budget(tinybit_ctx* ctx, uint32_t instructions, uint32_t time_us, enum TinyBitBudgetMode mode);
+
+// Count calls, time and pixels per Lua API binding, per frame
+void tinybit_api_stats_enable(tinybit_ctx* ctx, bool enabled);
+int tinybit_api_stats(tinybit_ctx* ctx, struct TinyBitApiStat* stats, int max);
+
+// Sample Lua call stacks into a host buffer and dump them as folded stacks
+bool tinybit_profile_start(tinybit_ctx* ctx, void* buffer, size_t size, enum TinyBitProfileMode mode, uint32_t interval);
+void tinybit_profile_stop(tinybit_ctx* ctx);
+size_t tinybit_profile_dump(tinybit_ctx* ctx, char* out, size_t capacity);
+void tinybit_profile_tick(tinybit_ctx* ctx);
+
+// Record button input per frame into a host buffer, or replay a recording
+bool tinybit_record_start(tinybit_ctx* ctx, uint8_t* buffer, size_t capacity);
+size_t tinybit_record_stop(tinybit_ctx* ctx);
+bool tinybit_replay_start(tinybit_ctx* ctx, const uint8_t* stream, size_t size);
+bool tinybit_replay_active(tinybit_ctx* ctx);
+
+// Compile Lua source into a stripped binary chunk for a bytecode cartridge
+size_t tinybit_compile(tinybit_ctx* ctx, const char* source, size_t size, uint8_t* out, size_t capacity);
+
+// Keep compiled text scripts in a host buffer so restarts skip the compiler
+void tinybit_chunk_cache(tinybit_ctx* ctx, void* buffer, size_t size);
+
+// Save and load the whole machine; restart from a snapshot instead of the script
+bool tinybit_snapshot(tinybit_ctx* ctx, struct TinyBitSnapshot* snap);
+bool tinybit_restore(tinybit_ctx* ctx, const struct TinyBitSnapshot* snap);
+void tinybit_set_restart_snapshot(tinybit_ctx* ctx, struct TinyBitSnapshot* snap);
+
+// Keep per-frame history in a host buffer and step back through it
+bool tinybit_rewind_buffer(tinybit_ctx* ctx, void* buffer, size_t size);
+int tinybit_rewind(tinybit_ctx* ctx, int frames);
+int tinybit_rewind_available(tinybit_ctx* ctx);
+
+// Host data attached to a context, e.g. for use inside callbacks
+void tinybit_set_user_data(tinybit_ctx* ctx, void* user_data);
+void* tinybit_get_user_data(tinybit_ctx* ctx);
+
+// Callback function setters
+void tinybit_log_cb(tinybit_ctx* ctx, void (*log_func_ptr)(tinybit_ctx* ctx, const char* message));
+void tinybit_get_ticks_ms_cb(tinybit_ctx* ctx, int (*get_ticks_ms_func_ptr)(tinybit_ctx* ctx));
+void tinybit_get_ticks_us_cb(tinybit_ctx* ctx, uint64_t (*get_ticks_us_func_ptr)(tinybit_ctx* ctx));
+void tinybit_render_cb(tinybit_ctx* ctx, void (*render_func_ptr)(tinybit_ctx* ctx));
+void tinybit_poll_input_cb(tinybit_ctx* ctx, void (*poll_input_func_ptr)(tinybit_ctx* ctx));
+void tinybit_audio_queue_cb(tinybit_ctx* ctx, void (*audio_queue_func_ptr)(tinybit_ctx* ctx));
+void tinybit_gamecount_cb(tinybit_ctx* ctx, int (*gamecount_func_ptr)(tinybit_ctx* ctx));
+void tinybit_gameload_cb(tinybit_ctx* ctx, void (*gameload_func_ptr)(tinybit_ctx* ctx, int index));
+void tinybit_error_cb(tinybit_ctx* ctx, void (*error_func_ptr)(tinybit_ctx* ctx, const char* message, const char* traceback));
+void tinybit_memory_cb(tinybit_ctx* ctx, void (*memory_func_ptr)(tinybit_ctx* ctx, enum TinyBitMemoryEvent event, const struct TinyBitHeapStats* stats));
+
 #endif
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include "watchdog.h"
+
+#include "lua/lua.h"
+#include "lua/lauxlib.h"
+
+#include "tinybit.h"
+#include "lua_functions.h"  // tb_ctx
+#include "stats.h"
+#include "profiler.h"
+
+// VM instructions between budget checks; the instruction budget is
+// enforced to this granularity
+#define HOOK_INTERVAL 1000
+
+// Registry key anchoring the coroutine _draw runs in with TB_BUDGET_YIELD
+#define DRAW_THREAD_KEY "tinybit.draw_thread"
+
+static bool has_budget(tinybit_ctx* ctx) {
+    return ctx->watchdog.instructions || ctx->watchdog.time_us;
+}
+
+static void watchdog_hook(lua_State* L, lua_Debug* ar);
+
+// (Re)install the count hook on L for the budget and instruction sampling,
+// or remove it if neither is on
+static void set_hook(tinybit_ctx* ctx, lua_State* L) {
+    bool budget = has_budget(ctx);
+    bool counting = profiler_counting(ctx);
+
+    if (!budget && !counting) {
+        lua_sethook(L, NULL, 0, 0);
+        return;
+    }
+    uint32_t interval = HOOK_INTERVAL;
+    if (counting && (!budget || ctx->profile.interval < interval)) {
+        interval = ctx->profile.interval;
+    }
+    ctx->watchdog.interval = interval;
+    lua_sethook(L, watchdog_hook, LUA_MASKCOUNT, (int)interval);
+}
+
+// The count hook is shared with the profiler
+static void watchdog_hook(lua_State* L, lua_Debug* ar) {
+    tinybit_ctx* ctx = tb_ctx(L);
+    (void)ar;
+
+    if (ctx->profile.sample_pending) {
+        // one-shot hook from a profiler timer tick
+        profiler_take_sample(ctx, L);
+        if (ctx->profile.thread == L) {
+            set_hook(ctx, L);
+        } else {
+            lua_sethook(L, NULL, 0, 0); // the tick landed after the call ended
+        }
+        return;
+    }
+    if (profiler_counting(ctx)) {
+        profiler_tick(ctx, L, ctx->watchdog.interval);
+    }
+    if (!has_budget(ctx)) {
+        return;
+    }
+
+    ctx->watchdog.remaining -= ctx->watchdog.interval;
+
+    bool over = (ctx->watchdog.instructions && ctx->watchdog.remaining <= 0)
+             || (ctx->watchdog.time_us && stats_clock_us(ctx) - ctx->watchdog.start_us >= ctx->watchdog.time_us);
+    if (!over) {
+        return;
+    }
+
+    ctx->stats.watchdog_trips++;
+    if (ctx->watchdog.mode == TB_BUDGET_YIELD && lua_isyieldable(L)) {
+        lua_yield(L, 0); // resumed by the next frame
+        return;
+    }
+    // the top-level script and code called from C can't yield; level 0 is
+    // the interrupted function, so the message points at the runaway code
+    luaL_where(L, 0);
+    lua_pushliteral(L, "frame budget exceeded");
+    lua_concat(L, 2);
+    lua_error(L);
+}
+
+// Start a frame's budget, shared by every callback the frame runs
+void watchdog_start(tinybit_ctx* ctx) {
+    ctx->watchdog.remaining = ctx->watchdog.instructions;
+    ctx->watchdog.start_us = has_budget(ctx) ? stats_clock_us(ctx) : 0;
+}
+
+// Charge code running on L to the frame's budget, and profile it if on
+void watchdog_arm(tinybit_ctx* ctx, lua_State* L) {
+    set_hook(ctx, L);
+    ctx->profile.thread = L;
+}
+
+void watchdog_disarm(lua_State* L) {
+    tb_ctx(L)->profile.thread = NULL;
+    lua_sethook(L, NULL, 0, 0);
+}
+
+// Host timer tick for TB_PROFILE_TIME; safe from a signal handler or
+// another thread
+void watchdog_profile_tick(tinybit_ctx* ctx) {
+    profiler_request_sample(ctx, watchdog_hook);
+}
+
+static int new_draw_thread(lua_State* L) {
+    lua_newthread(L);
+    lua_pushvalue(L, -1);
+    lua_setfield(L, LUA_REGISTRYINDEX, DRAW_THREAD_KEY);
+    return 1;
+}
+
+// The coroutine _draw runs in when it may be suspended across frames.
+// Kept in the registry, so it lives and dies with the Lua state. Created
+// in a protected call, since the heap may be full; on failure the error is
+// left on L's stack and its status returned.
+int watchdog_draw_thread(lua_State* L, lua_State** co) {
+    if (lua_getfield(L, LUA_REGISTRYINDEX, DRAW_THREAD_KEY) == LUA_TTHREAD) {
+        *co = lua_tothread(L, -1);
+        lua_pop(L, 1);
+        return LUA_OK;
+    }
+    lua_pop(L, 1);
+
+    lua_pushcfunction(L, new_draw_thread);
+    int status = lua_pcall(L, 0, 1, 0);
+    if (status != LUA_OK) {
+        return status;
+    }
+    *co = lua_tothread(L, -1);
+    lua_pop(L, 1);
+    return LUA_OK;
+}
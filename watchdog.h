@@ -0,0 +1,14 @@
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+#include "tinybit.h"
+
+struct lua_State;
+
+void watchdog_start(tinybit_ctx* ctx);
+void watchdog_arm(tinybit_ctx* ctx, struct lua_State* L);
+void watchdog_disarm(struct lua_State* L);
+void watchdog_profile_tick(tinybit_ctx* ctx);
+int watchdog_draw_thread(struct lua_State* L, struct lua_State** co);
+
+#endif